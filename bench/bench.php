@@ -0,0 +1,208 @@
+<?php
+/*
+ * Benchmark driver for the rocksdb extension.
+ *
+ * Runs each scenario against a temporary database and prints JSON with
+ * ops/sec and p50/p99 latency per call. When the raw_bench binary (built
+ * from raw_bench.c, see the Makefile) is available, the same scenarios run
+ * against librocksdb directly and every result gets a 'raw' entry plus
+ * 'overhead_ns_per_op', the extension's cost on top of RocksDB.
+ *
+ *   php -d extension=modules/rocksdb.so bench/bench.php \
+ *     [--keys=100000] [--value-size=100] [--raw=bench/raw_bench] \
+ *     [--filter=REGEX] [--out=FILE]
+ */
+
+$opts = getopt('', ['keys:', 'value-size:', 'raw:', 'filter:', 'out:']);
+$keys = (int)($opts['keys'] ?? 100000);
+$valueSize = (int)($opts['value-size'] ?? 100);
+$raw = $opts['raw'] ?? __DIR__ . '/raw_bench';
+$filter = $opts['filter'] ?? null;
+
+if (!extension_loaded('rocksdb')) {
+  fwrite(STDERR, "The rocksdb extension is not loaded (php -d extension=modules/rocksdb.so)\n");
+  exit(2);
+}
+if ($keys < 1) {
+  fwrite(STDERR, "--keys must be positive\n");
+  exit(2);
+}
+
+/* Same generator as raw_bench.c so both sides touch the same keys */
+$rngState = 42;
+function next_rand(): int {
+  global $rngState;
+  $rngState = ($rngState * 1103515245 + 12345) & 0x7fffffff;
+  return $rngState;
+}
+
+function make_key(string $prefix, int $i): string {
+  return sprintf('%s%08d', $prefix, $i % 100000000);
+}
+
+function remove_dir(string $dir): void {
+  if (!is_dir($dir)) {
+    return;
+  }
+  foreach (scandir($dir) as $entry) {
+    if ($entry !== '.' && $entry !== '..') {
+      $path = "$dir/$entry";
+      is_dir($path) ? remove_dir($path) : unlink($path);
+    }
+  }
+  rmdir($dir);
+}
+
+/*
+ * Times $calls invocations of $fn($i), which returns the number of
+ * operations it performed (keys read or written).
+ */
+function measure(string $name, int $calls, callable $fn): array {
+  $samples = [];
+  $ops = 0;
+  $start = hrtime(true);
+  for ($i = 0; $i < $calls; $i++) {
+    $t = hrtime(true);
+    $ops += $fn($i);
+    $samples[] = hrtime(true) - $t;
+  }
+  $elapsed = hrtime(true) - $start;
+  sort($samples);
+  $n = count($samples);
+  return [
+    'name' => $name,
+    'calls' => $n,
+    'ops' => $ops,
+    'ops_per_sec' => $elapsed ? round($ops * 1e9 / $elapsed, 1) : 0.0,
+    'ns_per_op' => $ops ? round($elapsed / $ops, 1) : 0.0,
+    'p50_ns' => $n ? $samples[intdiv($n - 1, 2)] : 0,
+    'p99_ns' => $n ? $samples[intdiv(($n - 1) * 99, 100)] : 0,
+  ];
+}
+
+$base = sys_get_temp_dir() . '/php-rocksdb-bench-' . getmypid();
+$value = str_repeat('v', $valueSize);
+$results = [];
+$run = function (string $name, int $calls, callable $fn) use (&$results, $filter) {
+  if ($filter === null || preg_match($filter, $name)) {
+    $results[$name] = measure($name, $calls, $fn);
+  }
+};
+
+/* Only create_if_missing, like raw_bench.c */
+$db = new RocksDB("$base/php", ['create_if_missing' => true]);
+
+$run('put', $keys, function (int $i) use ($db, $value) {
+  $db->put(make_key('key', $i), $value);
+  return 1;
+});
+if (!isset($results['put'])) {
+  /* The read scenarios need the data even when put is filtered out */
+  for ($i = 0; $i < $keys; $i++) {
+    $db->put(make_key('key', $i), $value);
+  }
+}
+
+foreach (['get_hit' => 'key', 'get_miss' => 'mis'] as $name => $prefix) {
+  $rngState = 42;
+  $run($name, $keys, function () use ($db, $prefix, $keys) {
+    $db->get(make_key($prefix, next_rand() % $keys));
+    return 1;
+  });
+}
+
+foreach ([1, 10, 100, 1000] as $batch) {
+  $rngState = 42;
+  $run("multiget_$batch", max(1, intdiv($keys, $batch)), function () use ($db, $batch, $keys) {
+    $list = [];
+    for ($j = 0; $j < $batch; $j++) {
+      $list[] = make_key('key', next_rand() % $keys);
+    }
+    $db->multiGet($list);
+    return $batch;
+  });
+}
+
+foreach ([10, 100, 1000] as $batch) {
+  foreach ([false, true] as $noWal) {
+    $wb = new RocksDBWriteBatch();
+    $writeOptions = ['disable_wal' => $noWal];
+    $run("batch_write_$batch" . ($noWal ? '_nowal' : ''), max(1, intdiv($keys, $batch)),
+      function (int $i) use ($db, $wb, $batch, $keys, $value, $writeOptions) {
+        $wb->clear();
+        for ($j = 0; $j < $batch; $j++) {
+          $wb->put(make_key('key', ($i * $batch + $j) % $keys), $value);
+        }
+        $db->write($wb, $writeOptions);
+        return $batch;
+      });
+  }
+}
+
+/* "key0000" covers the first 10000 keys */
+$run('scan_prefix', 20, function () use ($db) {
+  $n = 0;
+  foreach ($db->prefixSearch('key0000') as $k => $v) {
+    $n++;
+  }
+  return $n;
+});
+$run('scan_full', 3, function () use ($db) {
+  $n = 0;
+  foreach ($db->getIterator() as $k => $v) {
+    $n++;
+  }
+  return $n;
+});
+
+unset($db);
+
+/* Raw librocksdb baseline */
+$rawResults = [];
+if ($results && is_executable($raw)) {
+  $cmd = sprintf('%s --dir=%s --keys=%d --value-size=%d',
+    escapeshellarg($raw), escapeshellarg("$base/raw"), $keys, $valueSize);
+  if ($filter !== null) {
+    /* Only the scenarios --filter kept */
+    $cmd .= ' --only=' . escapeshellarg(implode(',', array_keys($results)));
+  }
+  $out = shell_exec($cmd);
+  $decoded = $out ? json_decode($out, true) : null;
+  if (!is_array($decoded) || !isset($decoded['results'])) {
+    fwrite(STDERR, "raw_bench failed; reporting extension numbers only\n");
+  } else {
+    foreach ($decoded['results'] as $r) {
+      $rawResults[$r['name']] = $r;
+    }
+  }
+} elseif ($results) {
+  fwrite(STDERR, "No raw_bench at $raw (make -C bench raw_bench); skipping the baseline\n");
+}
+
+remove_dir($base);
+
+$report = [
+  'meta' => [
+    'php' => PHP_VERSION,
+    'extension' => phpversion('rocksdb'),
+    'keys' => $keys,
+    'value_size' => $valueSize,
+    'time' => date(DATE_ATOM),
+    'commit' => trim((string)@shell_exec('git -C ' . escapeshellarg(dirname(__DIR__)) . ' rev-parse --short HEAD 2>/dev/null')),
+  ],
+  'results' => [],
+];
+foreach ($results as $name => $r) {
+  if (isset($rawResults[$name])) {
+    $r['raw'] = $rawResults[$name];
+    unset($r['raw']['name']);
+    $r['overhead_ns_per_op'] = round($r['ns_per_op'] - $rawResults[$name]['ns_per_op'], 1);
+  }
+  $report['results'][] = $r;
+}
+
+$json = json_encode($report, JSON_PRETTY_PRINT | JSON_UNESCAPED_SLASHES) . "\n";
+if (isset($opts['out'])) {
+  file_put_contents($opts['out'], $json);
+}
+echo $json;
@@ -0,0 +1,342 @@
+/*
+ * Raw librocksdb baseline for bench/bench.php: the same scenarios, keys,
+ * values and call granularity as the PHP driver, straight against the C
+ * API. The difference between the two is the extension's per-call cost.
+ *
+ *   raw_bench --dir=/tmp/x [--keys=100000] [--value-size=100] [--only=put,get_hit]
+ *
+ * --only runs just the named scenarios (bench.php passes the ones its
+ * --filter selected); the keys are loaded either way.
+ *
+ * Prints {"results": [...]} as JSON on stdout.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <rocksdb/c.h>
+
+#define KEY_LEN 11 /* "key" + 8 digits */
+
+typedef struct {
+  uint64_t *samples; /* ns per call */
+  size_t calls;
+  size_t ops;        /* operations done (keys read/written) */
+  uint64_t elapsed;  /* ns for the whole loop */
+} bench_result;
+
+static int first_result = 1;
+static uint32_t rng_state = 42;
+static const char *only = NULL; /* comma-separated scenario names */
+
+/* Same generator as bench.php so both sides touch the same keys */
+static uint32_t next_rand(void) {
+  rng_state = (uint32_t)(((uint64_t)rng_state * 1103515245 + 12345) & 0x7fffffff);
+  return rng_state;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void make_key(char *buf, const char *prefix, size_t i) {
+  char tmp[KEY_LEN + 1];
+  snprintf(tmp, sizeof(tmp), "%s%08zu", prefix, i % 100000000);
+  memcpy(buf, tmp, KEY_LEN);
+}
+
+static int selected(const char *name) {
+  const char *p = only;
+  size_t len = strlen(name);
+
+  if (!only) {
+    return 1;
+  }
+  while (p) {
+    if (strncmp(p, name, len) == 0 && (p[len] == ',' || p[len] == '\0')) {
+      return 1;
+    }
+    p = strchr(p, ',');
+    if (p) {
+      p++;
+    }
+  }
+  return 0;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void result_begin(bench_result *r, size_t calls) {
+  r->samples = malloc(sizeof(uint64_t) * (calls ? calls : 1));
+  r->calls = 0;
+  r->ops = 0;
+  r->elapsed = 0;
+}
+
+static void result_emit(const char *name, bench_result *r) {
+  uint64_t p50 = 0, p99 = 0;
+
+  if (r->calls) {
+    qsort(r->samples, r->calls, sizeof(uint64_t), cmp_u64);
+    p50 = r->samples[(r->calls - 1) / 2];
+    p99 = r->samples[(r->calls - 1) * 99 / 100];
+  }
+  printf("%s\n    {\"name\": \"%s\", \"calls\": %zu, \"ops\": %zu, "
+    "\"ops_per_sec\": %.1f, \"ns_per_op\": %.1f, \"p50_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64 "}",
+    first_result ? "" : ",", name, r->calls, r->ops,
+    r->elapsed ? r->ops * 1e9 / r->elapsed : 0.0,
+    r->ops ? (double)r->elapsed / r->ops : 0.0, p50, p99);
+  first_result = 0;
+  free(r->samples);
+}
+
+static void check(char *err, const char *what) {
+  if (err) {
+    fprintf(stderr, "%s: %s\n", what, err);
+    exit(1);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *dir = NULL;
+  size_t keys = 100000, value_size = 100, i, j;
+  size_t batch_sizes[] = {10, 100, 1000}, multiget_sizes[] = {1, 10, 100, 1000};
+  rocksdb_options_t *options;
+  rocksdb_readoptions_t *ro;
+  rocksdb_writeoptions_t *wo, *wo_nowal;
+  rocksdb_column_family_handle_t *cf;
+  rocksdb_t *db;
+  char *value, *err = NULL, name[64];
+  bench_result r;
+  int w;
+
+  for (w = 1; w < argc; w++) {
+    if (strncmp(argv[w], "--dir=", 6) == 0) {
+      dir = argv[w] + 6;
+    } else if (strncmp(argv[w], "--keys=", 7) == 0) {
+      keys = strtoul(argv[w] + 7, NULL, 10);
+    } else if (strncmp(argv[w], "--value-size=", 13) == 0) {
+      value_size = strtoul(argv[w] + 13, NULL, 10);
+    } else if (strncmp(argv[w], "--only=", 7) == 0) {
+      only = argv[w] + 7;
+    }
+  }
+  if (!dir || !keys) {
+    fprintf(stderr, "usage: %s --dir=PATH [--keys=N] [--value-size=N] [--only=NAME,...]\n", argv[0]);
+    return 2;
+  }
+
+  /* Matches the extension's defaults: only create_if_missing is set */
+  options = rocksdb_options_create();
+  rocksdb_options_set_create_if_missing(options, 1);
+  db = rocksdb_open(options, dir, &err);
+  check(err, "open");
+  cf = rocksdb_get_default_column_family_handle(db);
+  ro = rocksdb_readoptions_create();
+  wo = rocksdb_writeoptions_create();
+  wo_nowal = rocksdb_writeoptions_create();
+  rocksdb_writeoptions_disable_WAL(wo_nowal, 1);
+
+  value = malloc(value_size ? value_size : 1);
+  memset(value, 'v', value_size);
+
+  printf("{\"results\": [");
+
+  /* put: loads the key space the reads below use, so it runs even when
+     not selected */
+  {
+    char key[KEY_LEN];
+    uint64_t start = now_ns();
+    result_begin(&r, keys);
+    for (i = 0; i < keys; i++) {
+      uint64_t t = now_ns();
+      make_key(key, "key", i);
+      rocksdb_put(db, wo, key, KEY_LEN, value, value_size, &err);
+      check(err, "put");
+      r.samples[r.calls++] = now_ns() - t;
+    }
+    r.ops = keys;
+    r.elapsed = now_ns() - start;
+    if (selected("put")) {
+      result_emit("put", &r);
+    } else {
+      free(r.samples);
+    }
+  }
+
+  /* get hit / miss */
+  for (w = 0; w < 2; w++) {
+    char key[KEY_LEN];
+    uint64_t start;
+    if (!selected(w ? "get_miss" : "get_hit")) {
+      continue;
+    }
+    start = now_ns();
+    rng_state = 42;
+    result_begin(&r, keys);
+    for (i = 0; i < keys; i++) {
+      uint64_t t = now_ns();
+      rocksdb_pinnableslice_t *slice;
+      make_key(key, w ? "mis" : "key", next_rand() % keys);
+      slice = rocksdb_get_pinned(db, ro, key, KEY_LEN, &err);
+      check(err, "get");
+      if (slice) {
+        size_t len;
+        const char *v = rocksdb_pinnableslice_value(slice, &len);
+        /* The binding copies the value out; do the same here */
+        char *copy = malloc(len ? len : 1);
+        memcpy(copy, v, len);
+        free(copy);
+        rocksdb_pinnableslice_destroy(slice);
+      }
+      r.samples[r.calls++] = now_ns() - t;
+    }
+    r.ops = keys;
+    r.elapsed = now_ns() - start;
+    result_emit(w ? "get_miss" : "get_hit", &r);
+  }
+
+  /* multiGet at several batch sizes */
+  for (w = 0; w < (int)(sizeof(multiget_sizes) / sizeof(multiget_sizes[0])); w++) {
+    size_t batch = multiget_sizes[w], calls = keys / batch ? keys / batch : 1;
+    char *key_buf;
+    const char **key_ptrs;
+    size_t *key_lens;
+    rocksdb_pinnableslice_t **values;
+    char **errs;
+    uint64_t start;
+
+    snprintf(name, sizeof(name), "multiget_%zu", batch);
+    if (!selected(name)) {
+      continue;
+    }
+    key_buf = malloc(batch * KEY_LEN);
+    key_ptrs = malloc(sizeof(char *) * batch);
+    key_lens = malloc(sizeof(size_t) * batch);
+    values = malloc(sizeof(rocksdb_pinnableslice_t *) * batch);
+    errs = malloc(sizeof(char *) * batch);
+    rng_state = 42;
+    result_begin(&r, calls);
+    start = now_ns();
+    for (i = 0; i < calls; i++) {
+      uint64_t t = now_ns();
+      for (j = 0; j < batch; j++) {
+        make_key(key_buf + j * KEY_LEN, "key", next_rand() % keys);
+        key_ptrs[j] = key_buf + j * KEY_LEN;
+        key_lens[j] = KEY_LEN;
+      }
+      rocksdb_batched_multi_get_cf(db, ro, cf, batch, key_ptrs, key_lens, values, errs, 0);
+      for (j = 0; j < batch; j++) {
+        check(errs[j], "multi_get");
+        if (values[j]) {
+          size_t len;
+          const char *v = rocksdb_pinnableslice_value(values[j], &len);
+          /* The binding copies each value out, as get does */
+          char *copy = malloc(len ? len : 1);
+          memcpy(copy, v, len);
+          free(copy);
+          rocksdb_pinnableslice_destroy(values[j]);
+        }
+      }
+      r.samples[r.calls++] = now_ns() - t;
+    }
+    r.ops = calls * batch;
+    r.elapsed = now_ns() - start;
+    result_emit(name, &r);
+    free(key_buf);
+    free(key_ptrs);
+    free(key_lens);
+    free(values);
+    free(errs);
+  }
+
+  /* WriteBatch + write, with and without the WAL */
+  for (w = 0; w < (int)(2 * sizeof(batch_sizes) / sizeof(batch_sizes[0])); w++) {
+    size_t batch = batch_sizes[w / 2], calls = keys / batch ? keys / batch : 1;
+    int nowal = w % 2;
+    rocksdb_writebatch_t *wb;
+    char key[KEY_LEN];
+    uint64_t start;
+
+    snprintf(name, sizeof(name), "batch_write_%zu%s", batch, nowal ? "_nowal" : "");
+    if (!selected(name)) {
+      continue;
+    }
+    wb = rocksdb_writebatch_create();
+    result_begin(&r, calls);
+    start = now_ns();
+    for (i = 0; i < calls; i++) {
+      uint64_t t = now_ns();
+      rocksdb_writebatch_clear(wb);
+      for (j = 0; j < batch; j++) {
+        make_key(key, "key", (i * batch + j) % keys);
+        rocksdb_writebatch_put(wb, key, KEY_LEN, value, value_size);
+      }
+      rocksdb_write(db, nowal ? wo_nowal : wo, wb, &err);
+      check(err, "write");
+      r.samples[r.calls++] = now_ns() - t;
+    }
+    r.ops = calls * batch;
+    r.elapsed = now_ns() - start;
+    result_emit(name, &r);
+    rocksdb_writebatch_destroy(wb);
+  }
+
+  /* Prefix scans ("key0000" = the first 10000 keys) and full scans */
+  for (w = 0; w < 2; w++) {
+    size_t calls = w ? 3 : 20;
+    uint64_t start;
+
+    if (!selected(w ? "scan_full" : "scan_prefix")) {
+      continue;
+    }
+    result_begin(&r, calls);
+    start = now_ns();
+    for (i = 0; i < calls; i++) {
+      uint64_t t = now_ns();
+      rocksdb_readoptions_t *sro = rocksdb_readoptions_create();
+      rocksdb_iterator_t *iter;
+      if (!w) {
+        rocksdb_readoptions_set_iterate_upper_bound(sro, "key0001", 7);
+      }
+      iter = rocksdb_create_iterator(db, sro);
+      if (w) {
+        rocksdb_iter_seek_to_first(iter);
+      } else {
+        rocksdb_iter_seek(iter, "key0000", 7);
+      }
+      for (; rocksdb_iter_valid(iter); rocksdb_iter_next(iter)) {
+        size_t klen, vlen;
+        const char *k = rocksdb_iter_key(iter, &klen);
+        const char *v = rocksdb_iter_value(iter, &vlen);
+        char *copy = malloc(klen + vlen + 1);
+        memcpy(copy, k, klen);
+        memcpy(copy + klen, v, vlen);
+        free(copy);
+        r.ops++;
+      }
+      rocksdb_iter_destroy(iter);
+      rocksdb_readoptions_destroy(sro);
+      r.samples[r.calls++] = now_ns() - t;
+    }
+    r.elapsed = now_ns() - start;
+    result_emit(w ? "scan_full" : "scan_prefix", &r);
+  }
+
+  printf("\n]}\n");
+
+  free(value);
+  rocksdb_column_family_handle_destroy(cf);
+  rocksdb_writeoptions_destroy(wo);
+  rocksdb_writeoptions_destroy(wo_nowal);
+  rocksdb_readoptions_destroy(ro);
+  rocksdb_close(db);
+  rocksdb_options_destroy(options);
+  return 0;
+}
@@ -53,6 +53,9 @@ if test "$PHP_ROCKSDB" != "no"; then
   LIBNAME=rocksdb
   PHP_ADD_LIBRARY_WITH_PATH($LIBNAME, $ROCKSDB_LIB_DIR, ROCKSDB_SHARED_LIBADD)
 
+  dnl RocksDB::parallelScan() runs its shards on native threads
+  PHP_ADD_LIBRARY(pthread,, ROCKSDB_SHARED_LIBADD)
+
   PHP_SUBST(ROCKSDB_SHARED_LIBADD)
 
   PHP_NEW_EXTENSION(rocksdb, php_rocksdb.c, $ext_shared)
@@ -15,6 +15,13 @@
 #include "php.h"
 #include "ext/standard/info.h"
 #include "zend_exceptions.h"
+#include "zend_smart_str.h"
+#include "zend_interfaces.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 #include <rocksdb/c.h>
 #include "php_rocksdb.h"
 
@@ -26,25 +33,174 @@
     return; \
   }
 
+/* Filter types accepted by the 'filter_type' option */
+#define PHP_ROCKSDB_BLOOM_FILTER  0
+#define PHP_ROCKSDB_RIBBON_FILTER 1
+
+/* RocksDBIterator::fetch() modes */
+#define PHP_ROCKSDB_FETCH_KEYS_AND_VALUES 0
+#define PHP_ROCKSDB_FETCH_KEYS_ONLY       1
+#define PHP_ROCKSDB_FETCH_VALUES_ONLY     2
+/* OR'ed into a fetch mode: decode values written by RocksDB::putValue() */
+#define PHP_ROCKSDB_FETCH_DECODE_VALUES   4
+
+/* Built-in merge operators selected by the 'merge_operator' option */
+#define PHP_ROCKSDB_MERGE_ADD    0
+#define PHP_ROCKSDB_MERGE_MAX    1
+#define PHP_ROCKSDB_MERGE_MIN    2
+#define PHP_ROCKSDB_MERGE_APPEND 3
+
+/* How php_rocksdb_open() opens the DB */
+#define PHP_ROCKSDB_OPEN_READ_WRITE  0
+#define PHP_ROCKSDB_OPEN_READ_ONLY   1
+#define PHP_ROCKSDB_OPEN_PESSIMISTIC 2  /* TransactionDB */
+#define PHP_ROCKSDB_OPEN_OPTIMISTIC  3  /* OptimisticTransactionDB */
+#define PHP_ROCKSDB_OPEN_SECONDARY   4  /* follows a primary, tryCatchUpWithPrimary() */
+#define PHP_ROCKSDB_OPEN_TTL         5  /* DBWithTTL, 'ttl' option */
+
+/* Under the 'expiry_filter' option every value written by put(), putValue()
+   and RocksDBTransaction::put() starts with a fixed header: 0xFE 0xE7, then
+   the expiry time as a big-endian uint64 of Unix seconds, 0 for never.
+   Compactions drop expired entries and reads hide them. Values without the
+   header (written before the option was set) are read as they are; write
+   batch values and merge operands are not framed, so on such a DB they must
+   not start with the header bytes. */
+#define PHP_ROCKSDB_EXPIRY_MAGIC0     0xFE
+#define PHP_ROCKSDB_EXPIRY_MAGIC1     0xE7
+#define PHP_ROCKSDB_EXPIRY_HEADER_LEN 10
+
+/* RocksDB::parallelScan() aggregates, combined as a bitmask */
+#define PHP_ROCKSDB_SCAN_COUNT    1
+#define PHP_ROCKSDB_SCAN_BYTES    2
+#define PHP_ROCKSDB_SCAN_MIN_MAX  4
+#define PHP_ROCKSDB_SCAN_CHECKSUM 8
+#define PHP_ROCKSDB_SCAN_ALL      15
+#define PHP_ROCKSDB_SCAN_MAX_THREADS 64
+
+/* Per-call read/write option objects kept per RocksDB instance */
+#define PHP_ROCKSDB_OPTIONS_CACHE_SIZE 32
+
+/* Prefix extractor kinds */
+#define PHP_ROCKSDB_PREFIX_NONE   0
+#define PHP_ROCKSDB_PREFIX_FIXED  1
+#define PHP_ROCKSDB_PREFIX_CAPPED 2
+
+ZEND_DECLARE_MODULE_GLOBALS(rocksdb)
+
 /* Handler declarations */
 zend_object_handlers rocksdb_object_handlers;
 zend_object_handlers rocksdb_write_batch_object_handlers;
 zend_object_handlers rocksdb_iterator_object_handlers;
+zend_object_handlers rocksdb_cache_object_handlers;
+zend_object_handlers rocksdb_snapshot_object_handlers;
+zend_object_handlers rocksdb_column_family_object_handlers;
+zend_object_handlers rocksdb_sst_file_writer_object_handlers;
+zend_object_handlers rocksdb_write_buffer_manager_object_handlers;
+zend_object_handlers rocksdb_rate_limiter_object_handlers;
+zend_object_handlers rocksdb_transaction_object_handlers;
 
 /* Class entries */
 zend_class_entry *php_rocksdb_ce;
 zend_class_entry *php_rocksdb_write_batch_ce;
 zend_class_entry *php_rocksdb_iterator_ce;
+zend_class_entry *php_rocksdb_cache_ce;
+zend_class_entry *php_rocksdb_snapshot_ce;
+zend_class_entry *php_rocksdb_column_family_ce;
+zend_class_entry *php_rocksdb_sst_file_writer_ce;
+zend_class_entry *php_rocksdb_write_buffer_manager_ce;
+zend_class_entry *php_rocksdb_rate_limiter_ce;
+zend_class_entry *php_rocksdb_transaction_ce;
 zend_class_entry *php_rocksdb_exception_ce;
 
 /* ---------------------- Internal Structures ---------------------- */
 
+/* LRU cache shared between RocksDBCache objects, the DBs configured with it
+   and persistent handles; released when the last holder lets go. */
+typedef struct _php_rocksdb_cache {
+  rocksdb_cache_t *cache;
+  size_t capacity;               /* as created; keys persistent handles */
+  zend_bool strict;
+  uint32_t refcount;
+} php_rocksdb_cache;
+
+/* Write buffer manager and rate limiter shared by every object constructed
+   with the same arguments, so all DBs of a worker draw on one budget.
+   Registered by key in ROCKSDB_G(write_buffer_managers) / rate_limiters and
+   released when the last object, DB or persistent handle lets go. The
+   signature (the constructor arguments) keys persistent DB handles; the
+   registry key also tells apart managers charged to different caches. */
+typedef struct _php_rocksdb_write_buffer_manager {
+  rocksdb_write_buffer_manager_t *wbm;
+  php_rocksdb_cache *cache;
+  HashTable *registry;
+  zend_string *key;
+  zend_string *signature;
+  uint32_t refcount;
+} php_rocksdb_write_buffer_manager;
+
+typedef struct _php_rocksdb_rate_limiter {
+  rocksdb_ratelimiter_t *limiter;
+  HashTable *registry;
+  zend_string *signature;        /* also the registry key */
+  uint32_t refcount;
+} php_rocksdb_rate_limiter;
+
+/* Column family handle, registered by name in the column_families table of
+   the DB that opened it and shared with every RocksDBColumnFamily referring
+   to it. A dropped family stays usable until its last holder lets go. */
+typedef struct _php_rocksdb_column_family {
+  rocksdb_column_family_handle_t *handle;
+  char *name;
+  php_rocksdb_cache *block_cache;
+  int prefix_extractor;          /* PHP_ROCKSDB_PREFIX_* */
+  size_t prefix_extractor_len;
+  zend_bool dropped;
+  uint32_t refcount;
+} php_rocksdb_column_family;
+
+/* Persistent DB handle, owned by ROCKSDB_G(persistent_dbs) and closed at
+   module shutdown. */
+typedef struct _php_rocksdb_persistent {
+  rocksdb_t *db;
+  rocksdb_transactiondb_t *txn_db;
+  rocksdb_optimistictransactiondb_t *otxn_db;
+  rocksdb_options_t *options;
+  php_rocksdb_cache *block_cache;
+  php_rocksdb_cache *row_cache;
+  php_rocksdb_write_buffer_manager *write_buffer_manager;
+  php_rocksdb_rate_limiter *rate_limiter;
+  HashTable *column_families;
+  uint64_t last_catch_up_ms;     /* shared by every request on this handle */
+} php_rocksdb_persistent;
+
 /* RocksDB object */
 typedef struct _rocksdb_object {
+  /* For transaction DBs, db wraps the base DB of txn_db/otxn_db: reads go
+     straight to it, pessimistic writes go through txn_db to take locks */
   rocksdb_t *db;
+  rocksdb_transactiondb_t *txn_db;
+  rocksdb_optimistictransactiondb_t *otxn_db;
   rocksdb_options_t *options;
   rocksdb_readoptions_t *read_options;
   rocksdb_writeoptions_t *write_options;
+  /* 'read_options'/'write_options' given at open, the base for per-call
+     arrays, and the option objects built from those arrays by signature */
+  zval read_options_defaults;
+  zval write_options_defaults;
+  HashTable *read_options_cache;
+  HashTable *write_options_cache;
+  php_rocksdb_cache *block_cache;
+  php_rocksdb_cache *row_cache;
+  php_rocksdb_write_buffer_manager *write_buffer_manager;
+  php_rocksdb_rate_limiter *rate_limiter;
+  int prefix_extractor;          /* PHP_ROCKSDB_PREFIX_* */
+  size_t prefix_extractor_len;
+  HashTable *column_families;    /* name => php_rocksdb_column_family */
+  php_rocksdb_persistent *persistent;
+  zend_bool expiry_filter;       /* values may carry an expiry header */
+  /* Secondary instances: tryCatchUpWithPrimary() throttle */
+  zend_long catch_up_interval_ms;
+  uint64_t last_catch_up_ms;
   zend_object std;
 } rocksdb_object;
 
@@ -55,6 +211,9 @@ static inline rocksdb_object *php_rocksdb_object_from_zobj(zend_object *obj) {
 /* WriteBatch object */
 typedef struct _rocksdb_write_batch_object {
   rocksdb_writebatch_t *batch;
+  /* Holds a value starting with the expiry header bytes; write() refuses
+     it on an 'expiry_filter' DB */
+  zend_bool expiry_ambiguous;
   zend_object std;
 } rocksdb_write_batch_object;
 
@@ -64,12 +223,76 @@ php_rocksdb_write_batch_object_from_zobj(zend_object *obj) {
     - XtOffsetOf(rocksdb_write_batch_object, std));
 }
 
+/* Snapshot object; keeps its RocksDB object alive until released */
+typedef struct _rocksdb_snapshot_object {
+  const rocksdb_snapshot_t *snapshot;
+  rocksdb_object *db_obj;
+  /* Iterators reading from the snapshot; release() waits for them */
+  uint32_t live_iterators;
+  zend_bool release_pending;
+  zend_object std;
+} rocksdb_snapshot_object;
+
+static inline rocksdb_snapshot_object *
+php_rocksdb_snapshot_object_from_zobj(zend_object *obj) {
+  return (rocksdb_snapshot_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_snapshot_object, std));
+}
+
+/* Column family object; keeps its RocksDB object alive */
+typedef struct _rocksdb_column_family_object {
+  php_rocksdb_column_family *cf;
+  rocksdb_object *db_obj;
+  zend_object std;
+} rocksdb_column_family_object;
+
+static inline rocksdb_column_family_object *
+php_rocksdb_column_family_object_from_zobj(zend_object *obj) {
+  return (rocksdb_column_family_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_column_family_object, std));
+}
+
 /* Iterator object */
+/* Transaction object; holds its DB so the transaction is destroyed first */
+typedef struct _rocksdb_transaction_object {
+  rocksdb_transaction_t *txn;
+  rocksdb_object *db_obj;
+  /* Set with 'set_snapshot': reads inside the transaction go through it */
+  const rocksdb_snapshot_t *snapshot;
+  zend_bool finished;
+  /* Live iterators (handle => rocksdb_iterator_object *). Their engine
+     iterators read the transaction's write batch, so commit(), rollback()
+     and rollbackToSavePoint() invalidate them first. */
+  HashTable iterators;
+  zend_object std;
+} rocksdb_transaction_object;
+
+static inline rocksdb_transaction_object *
+php_rocksdb_transaction_object_from_zobj(zend_object *obj) {
+  return (rocksdb_transaction_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_transaction_object, std));
+}
+
 typedef struct _rocksdb_iterator_object {
   rocksdb_iterator_t *iter;
+  rocksdb_readoptions_t *read_options;
   rocksdb_object *db_obj;
+  rocksdb_snapshot_object *snapshot_obj;
+  rocksdb_column_family_object *cf_obj;
+  /* Set before php_rocksdb_iterator_init() to iterate through a transaction */
+  rocksdb_transaction_object *txn_obj;
   char *prefix;
   size_t prefix_len;
+  /* [lower_bound, upper_bound) handed to the engine; the read options only
+     keep a slice, so the buffers live here for the iterator's lifetime. */
+  char *lower_bound;
+  size_t lower_bound_len;
+  char *upper_bound;
+  size_t upper_bound_len;
+  zend_bool decode_values;   /* current()/foreach decode putValue() values */
+  zend_bool backward;        /* last move was towards smaller keys */
+  zend_bool prefix_mode;     /* read with prefix_same_as_start, forward only */
+  zend_bool invalidated;     /* its transaction ended or rolled back */
   zend_object std;
 } rocksdb_iterator_object;
 
@@ -79,15 +302,241 @@ php_rocksdb_iterator_object_from_zobj(zend_object *obj) {
     - XtOffsetOf(rocksdb_iterator_object, std));
 }
 
+/* False (with an exception set) once the iterator's transaction has
+   invalidated it */
+static zend_bool php_rocksdb_iterator_usable(rocksdb_iterator_object *it_obj) {
+  if (it_obj->invalidated) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Iterator was invalidated by commit(), rollback() or rollbackToSavePoint() of its transaction", 0);
+    return 0;
+  }
+  return 1;
+}
+
+/* Cache object */
+typedef struct _rocksdb_cache_object {
+  php_rocksdb_cache *cache;
+  zend_object std;
+} rocksdb_cache_object;
+
+static inline rocksdb_cache_object *
+php_rocksdb_cache_object_from_zobj(zend_object *obj) {
+  return (rocksdb_cache_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_cache_object, std));
+}
+
+/* SstFileWriter object; the options outlive the writer built from them */
+typedef struct _rocksdb_sst_file_writer_object {
+  rocksdb_sstfilewriter_t *writer;
+  rocksdb_options_t *options;
+  rocksdb_envoptions_t *env_options;
+  zend_object std;
+} rocksdb_sst_file_writer_object;
+
+static inline rocksdb_sst_file_writer_object *
+php_rocksdb_sst_file_writer_object_from_zobj(zend_object *obj) {
+  return (rocksdb_sst_file_writer_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_sst_file_writer_object, std));
+}
+
+/* WriteBufferManager and RateLimiter objects, views of the shared ones */
+typedef struct _rocksdb_write_buffer_manager_object {
+  php_rocksdb_write_buffer_manager *wbm;
+  zend_object std;
+} rocksdb_write_buffer_manager_object;
+
+static inline rocksdb_write_buffer_manager_object *
+php_rocksdb_write_buffer_manager_object_from_zobj(zend_object *obj) {
+  return (rocksdb_write_buffer_manager_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_write_buffer_manager_object, std));
+}
+
+typedef struct _rocksdb_rate_limiter_object {
+  php_rocksdb_rate_limiter *limiter;
+  zend_object std;
+} rocksdb_rate_limiter_object;
+
+static inline rocksdb_rate_limiter_object *
+php_rocksdb_rate_limiter_object_from_zobj(zend_object *obj) {
+  return (rocksdb_rate_limiter_object *)((char*)(obj)
+    - XtOffsetOf(rocksdb_rate_limiter_object, std));
+}
+
 /* ---------------------- Free / Create Methods ---------------------- */
 
+static php_rocksdb_cache *php_rocksdb_cache_create(size_t capacity, zend_bool strict) {
+  php_rocksdb_cache *c = pemalloc(sizeof(php_rocksdb_cache), 1);
+  c->cache = strict
+    ? rocksdb_cache_create_lru_with_strict_capacity_limit(capacity)
+    : rocksdb_cache_create_lru(capacity);
+  c->capacity = capacity;
+  c->strict = strict;
+  c->refcount = 1;
+  return c;
+}
+
+static void php_rocksdb_cache_release(php_rocksdb_cache *c) {
+  if (c && --c->refcount == 0) {
+    rocksdb_cache_destroy(c->cache);
+    pefree(c, 1);
+  }
+}
+
+static void php_rocksdb_write_buffer_manager_release(php_rocksdb_write_buffer_manager *m) {
+  if (m && --m->refcount == 0) {
+    zend_hash_del(m->registry, m->key);
+    rocksdb_write_buffer_manager_destroy(m->wbm);
+    php_rocksdb_cache_release(m->cache);
+    zend_string_release(m->key);
+    zend_string_release(m->signature);
+    pefree(m, 1);
+  }
+}
+
+static void php_rocksdb_rate_limiter_release(php_rocksdb_rate_limiter *l) {
+  if (l && --l->refcount == 0) {
+    zend_hash_del(l->registry, l->signature);
+    rocksdb_ratelimiter_destroy(l->limiter);
+    zend_string_release(l->signature);
+    pefree(l, 1);
+  }
+}
+
+static php_rocksdb_column_family *php_rocksdb_column_family_create(const char *name) {
+  php_rocksdb_column_family *cf = pecalloc(1, sizeof(php_rocksdb_column_family), 1);
+  cf->name = pestrdup(name, 1);
+  cf->refcount = 1;
+  return cf;
+}
+
+static void php_rocksdb_column_family_release(php_rocksdb_column_family *cf) {
+  if (cf && --cf->refcount == 0) {
+    if (cf->handle) {
+      rocksdb_column_family_handle_destroy(cf->handle);
+    }
+    php_rocksdb_cache_release(cf->block_cache);
+    pefree(cf->name, 1);
+    pefree(cf, 1);
+  }
+}
+
+static void php_rocksdb_column_family_dtor(zval *zv) {
+  php_rocksdb_column_family_release(Z_PTR_P(zv));
+}
+
+/* Handles must all be destroyed before the DB is closed */
+static void php_rocksdb_column_families_destroy(HashTable *column_families) {
+  if (column_families) {
+    zend_hash_destroy(column_families);
+    pefree(column_families, 1);
+  }
+}
+
+/* For transaction DBs 'db' is only a wrapper around the base DB */
+static void php_rocksdb_close(rocksdb_t *db, rocksdb_transactiondb_t *txn_db,
+    rocksdb_optimistictransactiondb_t *otxn_db) {
+  if (txn_db) {
+    rocksdb_transactiondb_close_base_db(db);
+    rocksdb_transactiondb_close(txn_db);
+  } else if (otxn_db) {
+    rocksdb_optimistictransactiondb_close_base_db(db);
+    rocksdb_optimistictransactiondb_close(otxn_db);
+  } else if (db) {
+    rocksdb_close(db);
+  }
+}
+
+static void php_rocksdb_persistent_dtor(zval *zv) {
+  php_rocksdb_persistent *pdb = Z_PTR_P(zv);
+  php_rocksdb_column_families_destroy(pdb->column_families);
+  php_rocksdb_close(pdb->db, pdb->txn_db, pdb->otxn_db);
+  if (pdb->options) {
+    rocksdb_options_destroy(pdb->options);
+  }
+  php_rocksdb_cache_release(pdb->block_cache);
+  php_rocksdb_cache_release(pdb->row_cache);
+  php_rocksdb_write_buffer_manager_release(pdb->write_buffer_manager);
+  php_rocksdb_rate_limiter_release(pdb->rate_limiter);
+  pefree(pdb, 1);
+}
+
+/* Renders a RocksDBCache as "(capacity,strict)"; the capacity is the one it
+   was created with, setCapacity() does not change which handle it maps to. */
+static void php_rocksdb_cache_signature(smart_str *buf, php_rocksdb_cache *c) {
+  smart_str_appendc(buf, '(');
+  smart_str_append_unsigned(buf, c->capacity);
+  smart_str_appendc(buf, ',');
+  smart_str_appendc(buf, c->strict ? '1' : '0');
+  smart_str_appendc(buf, ')');
+}
+
+/* Object-valued options are keyed on their configuration, not their class,
+   so a later request passing differently configured objects gets its own
+   handle instead of silently inheriting the first request's. */
+static void php_rocksdb_object_signature(smart_str *buf, zend_object *zobj) {
+  smart_str_append(buf, zobj->ce->name);
+  if (instanceof_function(zobj->ce, php_rocksdb_cache_ce)) {
+    rocksdb_cache_object *cache_obj = php_rocksdb_cache_object_from_zobj(zobj);
+    if (cache_obj->cache) {
+      php_rocksdb_cache_signature(buf, cache_obj->cache);
+    }
+  } else if (instanceof_function(zobj->ce, php_rocksdb_write_buffer_manager_ce)) {
+    rocksdb_write_buffer_manager_object *wbm_obj =
+      php_rocksdb_write_buffer_manager_object_from_zobj(zobj);
+    if (wbm_obj->wbm) {
+      smart_str_append(buf, wbm_obj->wbm->signature);
+    }
+  } else if (instanceof_function(zobj->ce, php_rocksdb_rate_limiter_ce)) {
+    rocksdb_rate_limiter_object *rl_obj = php_rocksdb_rate_limiter_object_from_zobj(zobj);
+    if (rl_obj->limiter) {
+      smart_str_append(buf, rl_obj->limiter->signature);
+    }
+  }
+}
+
+/* Appends a canonical "key=value;" rendering of an options array, so two
+   option arrays that would configure the DB identically share a handle. */
+static void php_rocksdb_options_signature(smart_str *buf, HashTable *ht) {
+  zend_string *key;
+  zend_ulong idx;
+  zval *val;
+
+  ZEND_HASH_FOREACH_KEY_VAL(ht, idx, key, val) {
+    if (key) {
+      smart_str_append(buf, key);
+    } else {
+      smart_str_append_unsigned(buf, idx);
+    }
+    smart_str_appendc(buf, '=');
+    ZVAL_DEREF(val);
+    if (Z_TYPE_P(val) == IS_ARRAY) {
+      smart_str_appendc(buf, '[');
+      php_rocksdb_options_signature(buf, Z_ARRVAL_P(val));
+      smart_str_appendc(buf, ']');
+    } else if (Z_TYPE_P(val) == IS_OBJECT) {
+      php_rocksdb_object_signature(buf, Z_OBJ_P(val));
+    } else {
+      zend_string *str = zval_get_string(val);
+      smart_str_append(buf, str);
+      zend_string_release(str);
+    }
+    smart_str_appendc(buf, ';');
+  } ZEND_HASH_FOREACH_END();
+}
+
 static void php_rocksdb_object_free(zend_object *object) {
   rocksdb_object *obj = php_rocksdb_object_from_zobj(object);
-  if (obj->db) {
-    rocksdb_close(obj->db);
-  }
-  if (obj->options) {
-    rocksdb_options_destroy(obj->options);
+  /* A persistent handle stays open in the registry for the next request */
+  if (!obj->persistent) {
+    php_rocksdb_column_families_destroy(obj->column_families);
+    php_rocksdb_close(obj->db, obj->txn_db, obj->otxn_db);
+    if (obj->options) {
+      rocksdb_options_destroy(obj->options);
+    }
+    php_rocksdb_cache_release(obj->block_cache);
+    php_rocksdb_cache_release(obj->row_cache);
+    php_rocksdb_write_buffer_manager_release(obj->write_buffer_manager);
+    php_rocksdb_rate_limiter_release(obj->rate_limiter);
   }
   if (obj->read_options) {
     rocksdb_readoptions_destroy(obj->read_options);
@@ -95,6 +544,16 @@ static void php_rocksdb_object_free(zend_object *object) {
   if (obj->write_options) {
     rocksdb_writeoptions_destroy(obj->write_options);
   }
+  if (obj->read_options_cache) {
+    zend_hash_destroy(obj->read_options_cache);
+    FREE_HASHTABLE(obj->read_options_cache);
+  }
+  if (obj->write_options_cache) {
+    zend_hash_destroy(obj->write_options_cache);
+    FREE_HASHTABLE(obj->write_options_cache);
+  }
+  zval_ptr_dtor(&obj->read_options_defaults);
+  zval_ptr_dtor(&obj->write_options_defaults);
   zend_object_std_dtor(&obj->std);
 }
 
@@ -125,15 +584,48 @@ static zend_object *php_rocksdb_write_batch_object_new(zend_class_entry *ce) {
   return &obj->std;
 }
 
+static void php_rocksdb_snapshot_release(rocksdb_snapshot_object *obj) {
+  if (obj->snapshot) {
+    rocksdb_release_snapshot(obj->db_obj->db, obj->snapshot);
+    obj->snapshot = NULL;
+  }
+}
+
 static void php_rocksdb_iterator_object_free(zend_object *object) {
   rocksdb_iterator_object *obj =
     php_rocksdb_iterator_object_from_zobj(object);
   if (obj->iter) {
     rocksdb_iter_destroy(obj->iter);
   }
+  if (obj->read_options) {
+    rocksdb_readoptions_destroy(obj->read_options);
+  }
   if (obj->prefix) {
     efree(obj->prefix);
   }
+  if (obj->lower_bound) {
+    efree(obj->lower_bound);
+  }
+  if (obj->upper_bound) {
+    efree(obj->upper_bound);
+  }
+  if (obj->snapshot_obj) {
+    /* The engine iterator is gone; a deferred release() can happen now */
+    if (--obj->snapshot_obj->live_iterators == 0 && obj->snapshot_obj->release_pending) {
+      php_rocksdb_snapshot_release(obj->snapshot_obj);
+    }
+    OBJ_RELEASE(&obj->snapshot_obj->std);
+  }
+  if (obj->cf_obj) {
+    OBJ_RELEASE(&obj->cf_obj->std);
+  }
+  if (obj->txn_obj) {
+    zend_hash_index_del(&obj->txn_obj->iterators, obj->std.handle);
+    OBJ_RELEASE(&obj->txn_obj->std);
+  }
+  if (obj->db_obj) {
+    OBJ_RELEASE(&obj->db_obj->std);
+  }
   zend_object_std_dtor(&obj->std);
 }
 
@@ -146,195 +638,952 @@ static zend_object *php_rocksdb_iterator_object_new(zend_class_entry *ce) {
   return &obj->std;
 }
 
-/* ---------------------- Arginfo Declarations ---------------------- */
-
-/* RocksDB::compactRange(?string $begin = null, ?string $end = null): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_compactRange, 0, 0, 0)
-  ZEND_ARG_TYPE_INFO(0, begin, IS_STRING, 1)
-  ZEND_ARG_TYPE_INFO(0, end,   IS_STRING, 1)
-ZEND_END_ARG_INFO()
-
-/* RocksDB::__construct(string $path, array $options = null) */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb___construct, 0, 0, 1)
-  ZEND_ARG_TYPE_INFO(0, path, IS_STRING, 0)
-  ZEND_ARG_ARRAY_INFO(0, options, 1)
-ZEND_END_ARG_INFO()
-
-/* RocksDB::get(string $key): string|false */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_get, 0, 0, 1)
-  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_cache_object_free(zend_object *object) {
+  rocksdb_cache_object *obj = php_rocksdb_cache_object_from_zobj(object);
+  php_rocksdb_cache_release(obj->cache);
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDB::multiGet(array $keys): array */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_multiGet, 0, 0, 1)
-  ZEND_ARG_ARRAY_INFO(0, keys, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_cache_object_new(zend_class_entry *ce) {
+  rocksdb_cache_object *obj = ecalloc(1,
+    sizeof(rocksdb_cache_object) + zend_object_properties_size(ce));
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_cache_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDB::put(string $key, string $value): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_put, 0, 0, 2)
-  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
-  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_transaction_object_free(zend_object *object) {
+  rocksdb_transaction_object *obj = php_rocksdb_transaction_object_from_zobj(object);
+  if (obj->snapshot) {
+    /* Only the wrapper; the snapshot itself belongs to the transaction */
+    rocksdb_free((void *)obj->snapshot);
+  }
+  if (obj->txn) {
+    /* Uncommitted writes are discarded and the locks released */
+    rocksdb_transaction_destroy(obj->txn);
+  }
+  if (obj->db_obj) {
+    OBJ_RELEASE(&obj->db_obj->std);
+  }
+  zend_hash_destroy(&obj->iterators);
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDB::delete(string $key): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_delete, 0, 0, 1)
-  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_transaction_object_new(zend_class_entry *ce) {
+  rocksdb_transaction_object *obj = ecalloc(1,
+    sizeof(rocksdb_transaction_object) + zend_object_properties_size(ce));
+  zend_hash_init(&obj->iterators, 0, NULL, NULL, 0);
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_transaction_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDB::write(RocksDBWriteBatch $batch, array $writeOptions = null): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_write, 0, 0, 1)
-  ZEND_ARG_OBJ_INFO(0, batch, RocksDBWriteBatch, 0)
-  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_write_buffer_manager_object_free(zend_object *object) {
+  rocksdb_write_buffer_manager_object *obj =
+    php_rocksdb_write_buffer_manager_object_from_zobj(object);
+  php_rocksdb_write_buffer_manager_release(obj->wbm);
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDB::getIterator(): RocksDBIterator */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getIterator, 0, 0, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_write_buffer_manager_object_new(zend_class_entry *ce) {
+  rocksdb_write_buffer_manager_object *obj = ecalloc(1,
+    sizeof(rocksdb_write_buffer_manager_object) + zend_object_properties_size(ce));
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_write_buffer_manager_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDB::getProperty(string $name): string|null */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getProperty, 0, 0, 1)
-  ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_rate_limiter_object_free(zend_object *object) {
+  rocksdb_rate_limiter_object *obj = php_rocksdb_rate_limiter_object_from_zobj(object);
+  php_rocksdb_rate_limiter_release(obj->limiter);
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDB::prefixSearch(string $prefix): RocksDBIterator */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_prefixSearch, 0, 0, 1)
-  ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_rate_limiter_object_new(zend_class_entry *ce) {
+  rocksdb_rate_limiter_object *obj = ecalloc(1,
+    sizeof(rocksdb_rate_limiter_object) + zend_object_properties_size(ce));
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_rate_limiter_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDBWriteBatch::__construct() */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch___construct, 0, 0, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_sst_file_writer_object_free(zend_object *object) {
+  rocksdb_sst_file_writer_object *obj =
+    php_rocksdb_sst_file_writer_object_from_zobj(object);
+  if (obj->writer) {
+    rocksdb_sstfilewriter_destroy(obj->writer);
+  }
+  if (obj->options) {
+    rocksdb_options_destroy(obj->options);
+  }
+  if (obj->env_options) {
+    rocksdb_envoptions_destroy(obj->env_options);
+  }
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDBWriteBatch::put(string $key, string $value): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_put, 0, 0, 2)
-  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
-  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_sst_file_writer_object_new(zend_class_entry *ce) {
+  rocksdb_sst_file_writer_object *obj = ecalloc(1,
+    sizeof(rocksdb_sst_file_writer_object) + zend_object_properties_size(ce));
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_sst_file_writer_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDBWriteBatch::delete(string $key): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_delete, 0, 0, 1)
-  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_snapshot_object_free(zend_object *object) {
+  rocksdb_snapshot_object *obj = php_rocksdb_snapshot_object_from_zobj(object);
+  php_rocksdb_snapshot_release(obj);
+  if (obj->db_obj) {
+    OBJ_RELEASE(&obj->db_obj->std);
+  }
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDBWriteBatch::clear(): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_clear, 0, 0, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_snapshot_object_new(zend_class_entry *ce) {
+  rocksdb_snapshot_object *obj = ecalloc(1,
+    sizeof(rocksdb_snapshot_object) + zend_object_properties_size(ce));
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_snapshot_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDBIterator::__construct(RocksDB $db, string $prefix = null) */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator___construct, 0, 0, 1)
-  ZEND_ARG_OBJ_INFO(0, db, RocksDB, 0)
-  ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 1)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_column_family_object_free(zend_object *object) {
+  rocksdb_column_family_object *obj =
+    php_rocksdb_column_family_object_from_zobj(object);
+  php_rocksdb_column_family_release(obj->cf);
+  if (obj->db_obj) {
+    OBJ_RELEASE(&obj->db_obj->std);
+  }
+  zend_object_std_dtor(&obj->std);
+}
 
-/* RocksDBIterator::valid(): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_valid, 0, 0, 0)
-ZEND_END_ARG_INFO()
+static zend_object *php_rocksdb_column_family_object_new(zend_class_entry *ce) {
+  rocksdb_column_family_object *obj = ecalloc(1,
+    sizeof(rocksdb_column_family_object) + zend_object_properties_size(ce));
+  zend_object_std_init(&obj->std, ce);
+  object_properties_init(&obj->std, ce);
+  obj->std.handlers = &rocksdb_column_family_object_handlers;
+  return &obj->std;
+}
 
-/* RocksDBIterator::key(): string */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_key, 0, 0, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_column_family_object_init(zval *zv, rocksdb_object *db_obj,
+    php_rocksdb_column_family *cf) {
+  rocksdb_column_family_object *obj;
 
-/* RocksDBIterator::current(): string */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_current, 0, 0, 0)
-ZEND_END_ARG_INFO()
+  object_init_ex(zv, php_rocksdb_column_family_ce);
+  obj = php_rocksdb_column_family_object_from_zobj(Z_OBJ_P(zv));
+  obj->cf = cf;
+  cf->refcount++;
+  obj->db_obj = db_obj;
+  GC_ADDREF(&db_obj->std);
+}
 
-/* RocksDBIterator::next(): void */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_next, 0, 0, 0)
-ZEND_END_ARG_INFO()
+/* Resolves an optional RocksDBColumnFamily argument. db_obj may be NULL
+   (write batches are not tied to a DB). Returns NULL with an exception set
+   when it is dropped or was opened on another DB. */
+static rocksdb_column_family_object *php_rocksdb_column_family_from_zval(zval *zv,
+    rocksdb_object *db_obj) {
+  rocksdb_column_family_object *cf_obj =
+    php_rocksdb_column_family_object_from_zobj(Z_OBJ_P(zv));
+  if (!cf_obj->cf) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "RocksDBColumnFamily must be obtained from RocksDB::getColumnFamily()", 0);
+    return NULL;
+  }
+  if (cf_obj->cf->dropped) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Column family '%s' has been dropped", cf_obj->cf->name);
+    return NULL;
+  }
+  if (db_obj && cf_obj->db_obj->db != db_obj->db) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Column family '%s' belongs to a different database", cf_obj->cf->name);
+    return NULL;
+  }
+  return cf_obj;
+}
 
-/* RocksDBIterator::rewind(): void */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_rewind, 0, 0, 0)
-ZEND_END_ARG_INFO()
+static void php_rocksdb_snapshot_init(rocksdb_snapshot_object *snap_obj, rocksdb_object *db_obj) {
+  snap_obj->db_obj = db_obj;
+  GC_ADDREF(&db_obj->std);
+  snap_obj->snapshot = rocksdb_create_snapshot(db_obj->db);
+}
 
-/* RocksDBIterator::destroy(): bool */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_destroy, 0, 0, 0)
-ZEND_END_ARG_INFO()
+/* Resolves an optional RocksDBSnapshot argument. Returns NULL with an
+   exception set when it is released or was taken on another DB. */
+static rocksdb_snapshot_object *php_rocksdb_snapshot_from_zval(zval *zv,
+    rocksdb_object *db_obj) {
+  rocksdb_snapshot_object *snap_obj = php_rocksdb_snapshot_object_from_zobj(Z_OBJ_P(zv));
+  if (!snap_obj->snapshot || snap_obj->release_pending) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Snapshot has been released", 0);
+    return NULL;
+  }
+  if (snap_obj->db_obj->db != db_obj->db) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Snapshot belongs to a different database", 0);
+    return NULL;
+  }
+  return snap_obj;
+}
 
-/* ---------------------- Method Implementations ---------------------- */
+/* Resolves a cache option: a RocksDBCache object is shared, a size creates a
+   private LRU cache. Returns NULL (with an exception set) on a bad value. */
+static php_rocksdb_cache *php_rocksdb_cache_from_options(HashTable *ht,
+    const char *obj_key, size_t obj_key_len,
+    const char *size_key, size_t size_key_len, zend_bool *failed) {
+  zval *val;
+
+  if ((val = zend_hash_str_find(ht, obj_key, obj_key_len)) != NULL) {
+    rocksdb_cache_object *cache_obj;
+    if (Z_TYPE_P(val) != IS_OBJECT ||
+        !instanceof_function(Z_OBJCE_P(val), php_rocksdb_cache_ce)) {
+      zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+        "Option '%s' must be a RocksDBCache instance", obj_key);
+      *failed = 1;
+      return NULL;
+    }
+    cache_obj = php_rocksdb_cache_object_from_zobj(Z_OBJ_P(val));
+    if (!cache_obj->cache) {
+      zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+        "Option '%s' refers to an uninitialized RocksDBCache", obj_key);
+      *failed = 1;
+      return NULL;
+    }
+    cache_obj->cache->refcount++;
+    return cache_obj->cache;
+  }
+  if ((val = zend_hash_str_find(ht, size_key, size_key_len)) != NULL) {
+    zend_long size = zval_get_long(val);
+    if (size > 0) {
+      return php_rocksdb_cache_create((size_t)size, 0);
+    }
+  }
+  return NULL;
+}
 
-/* --- RocksDB::__construct(...) with advanced options --- */
-PHP_METHOD(RocksDB, __construct)
-{
-  char *path;
-  size_t path_len;
-  zval *options_zv = NULL;
-  char *err = NULL;
-  rocksdb_object *obj;
-  zend_bool read_only = 0;
+/* Read option keys: fill_cache, verify_checksums, readahead_size, async_io */
+static void php_rocksdb_readoptions_apply(rocksdb_readoptions_t *ro, zval *options_zv) {
+  zval *val;
+  HashTable *ht;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|a",
-      &path, &path_len, &options_zv) == FAILURE) {
+  if (!options_zv || Z_TYPE_P(options_zv) != IS_ARRAY) {
     return;
   }
+  ht = Z_ARRVAL_P(options_zv);
+  if ((val = zend_hash_str_find(ht, "fill_cache", sizeof("fill_cache") - 1)) != NULL) {
+    rocksdb_readoptions_set_fill_cache(ro, zend_is_true(val));
+  }
+  if ((val = zend_hash_str_find(ht, "verify_checksums", sizeof("verify_checksums") - 1)) != NULL) {
+    rocksdb_readoptions_set_verify_checksums(ro, zend_is_true(val));
+  }
+  if ((val = zend_hash_str_find(ht, "readahead_size", sizeof("readahead_size") - 1)) != NULL) {
+    rocksdb_readoptions_set_readahead_size(ro, (size_t)zval_get_long(val));
+  }
+  if ((val = zend_hash_str_find(ht, "async_io", sizeof("async_io") - 1)) != NULL) {
+    rocksdb_readoptions_set_async_io(ro, zend_is_true(val));
+  }
+}
 
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+/* Write option keys: sync, disable_wal, no_slowdown, low_pri */
+static void php_rocksdb_writeoptions_apply(rocksdb_writeoptions_t *wo, zval *options_zv) {
+  zval *val;
+  HashTable *ht;
 
-  obj->options = rocksdb_options_create();
-  rocksdb_options_set_create_if_missing(obj->options, 1);
+  if (!options_zv || Z_TYPE_P(options_zv) != IS_ARRAY) {
+    return;
+  }
+  ht = Z_ARRVAL_P(options_zv);
+  if ((val = zend_hash_str_find(ht, "sync", sizeof("sync") - 1)) != NULL) {
+    rocksdb_writeoptions_set_sync(wo, zend_is_true(val));
+  }
+  if ((val = zend_hash_str_find(ht, "disable_wal", sizeof("disable_wal") - 1)) != NULL) {
+    rocksdb_writeoptions_disable_WAL(wo, zend_is_true(val));
+  }
+  if ((val = zend_hash_str_find(ht, "no_slowdown", sizeof("no_slowdown") - 1)) != NULL) {
+    rocksdb_writeoptions_set_no_slowdown(wo, zend_is_true(val));
+  }
+  if ((val = zend_hash_str_find(ht, "low_pri", sizeof("low_pri") - 1)) != NULL) {
+    rocksdb_writeoptions_set_low_pri(wo, zend_is_true(val));
+  }
+}
 
-  rocksdb_block_based_table_options_t *table_opts = rocksdb_block_based_options_create();
+static void php_rocksdb_expiry_header(char *buf, uint64_t expires_at) {
+  int i;
 
-  if (options_zv && Z_TYPE_P(options_zv) == IS_ARRAY) {
-    zval *val;
-    HashTable *ht = Z_ARRVAL_P(options_zv);
+  buf[0] = (char)PHP_ROCKSDB_EXPIRY_MAGIC0;
+  buf[1] = (char)PHP_ROCKSDB_EXPIRY_MAGIC1;
+  for (i = 0; i < 8; i++) {
+    buf[2 + i] = (char)(expires_at >> (56 - i * 8));
+  }
+}
 
-    if ((val = zend_hash_str_find(ht, "read_only", sizeof("read_only") - 1)) != NULL) {
-      if (zend_is_true(val)) {
-        read_only = 1;
-        rocksdb_options_set_create_if_missing(obj->options, 0);
+static zend_bool php_rocksdb_expiry_parse(const char *val, size_t len, uint64_t *expires_at) {
+  const unsigned char *p = (const unsigned char *)val;
+  int i;
+
+  if (len < PHP_ROCKSDB_EXPIRY_HEADER_LEN
+      || p[0] != PHP_ROCKSDB_EXPIRY_MAGIC0 || p[1] != PHP_ROCKSDB_EXPIRY_MAGIC1) {
+    return 0;
+  }
+  *expires_at = 0;
+  for (i = 0; i < 8; i++) {
+    *expires_at = (*expires_at << 8) | p[2 + i];
+  }
+  return 1;
+}
+
+static zend_bool php_rocksdb_expiry_expired(uint64_t expires_at, uint64_t now) {
+  return expires_at != 0 && expires_at <= now;
+}
+
+/* Removes the expiry header from *val; returns 1 when the value had expired
+   by 'now' */
+static zend_bool php_rocksdb_expiry_strip_at(const char **val, size_t *len, uint64_t now) {
+  uint64_t expires_at;
+
+  if (!php_rocksdb_expiry_parse(*val, *len, &expires_at)) {
+    return 0;
+  }
+  *val += PHP_ROCKSDB_EXPIRY_HEADER_LEN;
+  *len -= PHP_ROCKSDB_EXPIRY_HEADER_LEN;
+  return php_rocksdb_expiry_expired(expires_at, now);
+}
+
+static zend_bool php_rocksdb_expiry_strip(const char **val, size_t *len) {
+  return php_rocksdb_expiry_strip_at(val, len, (uint64_t)time(NULL));
+}
+
+/* emalloc()ed copy of 'value' behind an expiry header; ttl 0 never expires */
+static char *php_rocksdb_expiry_frame(const char *value, size_t value_len,
+    zend_long ttl, size_t *framed_len) {
+  char *framed = emalloc(PHP_ROCKSDB_EXPIRY_HEADER_LEN + value_len);
+
+  php_rocksdb_expiry_header(framed, ttl > 0 ? (uint64_t)time(NULL) + (uint64_t)ttl : 0);
+  memcpy(framed + PHP_ROCKSDB_EXPIRY_HEADER_LEN, value, value_len);
+  *framed_len = PHP_ROCKSDB_EXPIRY_HEADER_LEN + value_len;
+  return framed;
+}
+
+/* True for an unframed value that reads would take for a framed one */
+static zend_bool php_rocksdb_expiry_ambiguous(const char *val, size_t len) {
+  uint64_t expires_at;
+  return php_rocksdb_expiry_parse(val, len, &expires_at);
+}
+
+/* Throws and returns 1 when an unframed write to an 'expiry_filter' DB
+   starts with the header bytes */
+static zend_bool php_rocksdb_expiry_reject(rocksdb_object *obj, const char *val, size_t len) {
+  if (obj->expiry_filter && php_rocksdb_expiry_ambiguous(val, len)) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Value starts with the expiry header bytes (0xFE 0xE7); use put() on a DB with 'expiry_filter'", 0);
+    return 1;
+  }
+  return 0;
+}
+
+/* True while the iterator sits on a key inside its range. The engine
+   enforces the upper bound; only an all-0xff prefix has none. */
+static zend_bool php_rocksdb_iterator_in_range(rocksdb_iterator_object *it_obj) {
+  if (!it_obj->iter || !rocksdb_iter_valid(it_obj->iter)) {
+    return 0;
+  }
+  /* Step over expired entries in the direction of the last move */
+  if (it_obj->db_obj->expiry_filter) {
+    for (;;) {
+      size_t val_len;
+      const char *val = rocksdb_iter_value(it_obj->iter, &val_len);
+      if (!php_rocksdb_expiry_strip(&val, &val_len)) {
+        break;
+      }
+      if (it_obj->backward) {
+        rocksdb_iter_prev(it_obj->iter);
+      } else {
+        rocksdb_iter_next(it_obj->iter);
       }
+      if (!rocksdb_iter_valid(it_obj->iter)) {
+        return 0;
+      }
+    }
+  }
+  if (it_obj->prefix && it_obj->prefix_len > 0 && !it_obj->upper_bound) {
+    size_t key_len;
+    const char *key = rocksdb_iter_key(it_obj->iter, &key_len);
+    if (key_len < it_obj->prefix_len ||
+        memcmp(key, it_obj->prefix, it_obj->prefix_len) != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Smallest key greater than every key starting with 'prefix': drop trailing
+   0xff bytes and increment the last remaining one. Returns NULL (no upper
+   bound) when the prefix is empty or all 0xff. */
+static char *php_rocksdb_prefix_successor(const char *prefix, size_t len, size_t *out_len) {
+  char *succ;
+
+  while (len > 0 && (unsigned char)prefix[len - 1] == 0xff) {
+    len--;
+  }
+  if (len == 0) {
+    return NULL;
+  }
+  succ = estrndup(prefix, len);
+  succ[len - 1] = (char)((unsigned char)succ[len - 1] + 1);
+  *out_len = len;
+  return succ;
+}
+
+/* Exclusive end of the keys starting with 'prefix' (emalloc()ed). Without a
+   successor (empty or all 0xff) every key >= prefix matches, so the range
+   ends just past the column family's last key. NULL when no key is at or
+   past the prefix, or on error. */
+static char *php_rocksdb_prefix_end(rocksdb_t *db, rocksdb_column_family_handle_t *cf,
+    const char *prefix, size_t len, size_t *out_len, char **err) {
+  char *end = php_rocksdb_prefix_successor(prefix, len, out_len);
+  rocksdb_readoptions_t *ro;
+  rocksdb_iterator_t *iter;
+
+  if (end) {
+    return end;
+  }
+  ro = rocksdb_readoptions_create();
+  iter = cf ? rocksdb_create_iterator_cf(db, ro, cf) : rocksdb_create_iterator(db, ro);
+  rocksdb_iter_seek_to_last(iter);
+  if (rocksdb_iter_valid(iter)) {
+    size_t last_len;
+    const char *last = rocksdb_iter_key(iter, &last_len);
+    if (zend_binary_strcmp(last, last_len, prefix, len) >= 0) {
+      end = emalloc(last_len + 1);
+      memcpy(end, last, last_len);
+      end[last_len] = '\0';
+      *out_len = last_len + 1;
     }
+  }
+  rocksdb_iter_get_error(iter, err);
+  rocksdb_iter_destroy(iter);
+  rocksdb_readoptions_destroy(ro);
+  if (*err != NULL && end) {
+    efree(end);
+    end = NULL;
+  }
+  return end;
+}
 
-    if ((val = zend_hash_str_find(ht, "create_if_missing", sizeof("create_if_missing") - 1)) != NULL) {
-      rocksdb_options_set_create_if_missing(obj->options, zend_is_true(val));
+/* Positions the iterator on the first key of its range */
+static void php_rocksdb_iterator_rewind(rocksdb_iterator_object *it_obj) {
+  if (!it_obj->iter) {
+    return;
+  }
+  it_obj->backward = 0;
+  if (it_obj->lower_bound) {
+    rocksdb_iter_seek(it_obj->iter, it_obj->lower_bound, it_obj->lower_bound_len);
+  } else {
+    rocksdb_iter_seek_to_first(it_obj->iter);
+  }
+}
+
+/* Creates the engine iterator from it_obj's read options, column family
+   and transaction */
+static void php_rocksdb_iterator_create(rocksdb_iterator_object *it_obj) {
+  rocksdb_column_family_object *cf_obj = it_obj->cf_obj;
+
+  if (it_obj->txn_obj) {
+    /* Merges the transaction's own uncommitted writes over the DB */
+    it_obj->iter = cf_obj
+      ? rocksdb_transaction_create_iterator_cf(it_obj->txn_obj->txn, it_obj->read_options,
+          cf_obj->cf->handle)
+      : rocksdb_transaction_create_iterator(it_obj->txn_obj->txn, it_obj->read_options);
+  } else {
+    it_obj->iter = cf_obj
+      ? rocksdb_create_iterator_cf(it_obj->db_obj->db, it_obj->read_options, cf_obj->cf->handle)
+      : rocksdb_create_iterator(it_obj->db_obj->db, it_obj->read_options);
+  }
+}
+
+/* Called before any backward move. In prefix mode the engine takes the
+   prefix of the seek target as "the" prefix, and SeekToLast() under an
+   upper bound seeks to the bound itself, i.e. the prefix successor, so
+   reverse scans come back empty. The bounds already confine the iterator
+   to the prefix, so switch it to total order, keeping its position. */
+static void php_rocksdb_iterator_total_order(rocksdb_iterator_object *it_obj) {
+  char *key = NULL;
+  size_t key_len = 0;
+
+  if (!it_obj->prefix_mode || !it_obj->iter) {
+    return;
+  }
+  if (rocksdb_iter_valid(it_obj->iter)) {
+    const char *k = rocksdb_iter_key(it_obj->iter, &key_len);
+    key = estrndup(k, key_len);
+  }
+  rocksdb_iter_destroy(it_obj->iter);
+  rocksdb_readoptions_set_prefix_same_as_start(it_obj->read_options, 0);
+  rocksdb_readoptions_set_total_order_seek(it_obj->read_options, 1);
+  it_obj->prefix_mode = 0;
+  php_rocksdb_iterator_create(it_obj);
+  if (key) {
+    rocksdb_iter_seek(it_obj->iter, key, key_len);
+    efree(key);
+  }
+}
+
+/* Sets up an iterator over [start, end) intersected with 'prefix' (any of
+   them may be NULL), optionally reading from a snapshot and/or a column
+   family with per-call read options, and positions it on the first key. */
+static void php_rocksdb_iterator_init(rocksdb_iterator_object *it_obj,
+    rocksdb_object *db_obj, const char *prefix, size_t prefix_len,
+    const char *start, size_t start_len, const char *end, size_t end_len,
+    rocksdb_snapshot_object *snap_obj, rocksdb_column_family_object *cf_obj,
+    zval *read_options_zv) {
+  int prefix_extractor = db_obj->prefix_extractor;
+  size_t prefix_extractor_len = db_obj->prefix_extractor_len;
+
+  it_obj->db_obj = db_obj;
+  GC_ADDREF(&db_obj->std);
+  it_obj->read_options = rocksdb_readoptions_create();
+  php_rocksdb_readoptions_apply(it_obj->read_options, &db_obj->read_options_defaults);
+  php_rocksdb_readoptions_apply(it_obj->read_options, read_options_zv);
+
+  if (snap_obj) {
+    it_obj->snapshot_obj = snap_obj;
+    GC_ADDREF(&snap_obj->std);
+    snap_obj->live_iterators++;
+    rocksdb_readoptions_set_snapshot(it_obj->read_options, snap_obj->snapshot);
+  }
+  if (cf_obj) {
+    it_obj->cf_obj = cf_obj;
+    GC_ADDREF(&cf_obj->std);
+    prefix_extractor = cf_obj->cf->prefix_extractor;
+    prefix_extractor_len = cf_obj->cf->prefix_extractor_len;
+  }
+  if (it_obj->txn_obj && it_obj->txn_obj->snapshot) {
+    rocksdb_readoptions_set_snapshot(it_obj->read_options, it_obj->txn_obj->snapshot);
+  }
+
+  if (prefix) {
+    it_obj->prefix_len = prefix_len;
+    it_obj->prefix = estrndup(prefix, prefix_len);
+    if (prefix_len > 0) {
+      it_obj->lower_bound = estrndup(prefix, prefix_len);
+      it_obj->lower_bound_len = prefix_len;
+      it_obj->upper_bound = php_rocksdb_prefix_successor(prefix, prefix_len,
+        &it_obj->upper_bound_len);
+    }
+  }
+
+  /* Intersect the prefix range with the explicit [start, end) bounds */
+  if (start && (!it_obj->lower_bound ||
+      zend_binary_strcmp(start, start_len, it_obj->lower_bound, it_obj->lower_bound_len) > 0)) {
+    if (it_obj->lower_bound) {
+      efree(it_obj->lower_bound);
+    }
+    it_obj->lower_bound = estrndup(start, start_len);
+    it_obj->lower_bound_len = start_len;
+  }
+  if (end && (!it_obj->upper_bound ||
+      zend_binary_strcmp(end, end_len, it_obj->upper_bound, it_obj->upper_bound_len) < 0)) {
+    if (it_obj->upper_bound) {
+      efree(it_obj->upper_bound);
+    }
+    it_obj->upper_bound = estrndup(end, end_len);
+    it_obj->upper_bound_len = end_len;
+  }
+
+  if (it_obj->lower_bound) {
+    rocksdb_readoptions_set_iterate_lower_bound(it_obj->read_options,
+      it_obj->lower_bound, it_obj->lower_bound_len);
+  }
+  if (it_obj->upper_bound) {
+    rocksdb_readoptions_set_iterate_upper_bound(it_obj->read_options,
+      it_obj->upper_bound, it_obj->upper_bound_len);
+  }
+
+  /* With a prefix extractor, a prefix at least as long as the extracted one
+     can be served in prefix mode (prefix blooms, no cross-prefix reads);
+     anything else must ask for total order or it may miss keys. Prefix
+     mode only holds until the first backward move, see above. */
+  if (prefix_extractor != PHP_ROCKSDB_PREFIX_NONE) {
+    if (it_obj->prefix && it_obj->prefix_len >= prefix_extractor_len) {
+      rocksdb_readoptions_set_prefix_same_as_start(it_obj->read_options, 1);
+      it_obj->prefix_mode = 1;
+    } else {
+      rocksdb_readoptions_set_total_order_seek(it_obj->read_options, 1);
+    }
+  }
+
+  php_rocksdb_iterator_create(it_obj);
+  php_rocksdb_iterator_rewind(it_obj);
+}
+
+/* Capped prefix extractor: the first 'len' bytes, or the whole key when it
+   is shorter. The C API only ships the fixed variant. */
+typedef struct _php_rocksdb_capped_prefix {
+  size_t len;
+  char name[48];
+} php_rocksdb_capped_prefix;
+
+static char *php_rocksdb_capped_prefix_transform(void *state, const char *key,
+    size_t length, size_t *dst_length) {
+  php_rocksdb_capped_prefix *cp = state;
+  *dst_length = length < cp->len ? length : cp->len;
+  return (char *)key;
+}
+
+static unsigned char php_rocksdb_capped_prefix_in_domain(void *state,
+    const char *key, size_t length) {
+  return 1;
+}
+
+static unsigned char php_rocksdb_capped_prefix_in_range(void *state,
+    const char *key, size_t length) {
+  return length <= ((php_rocksdb_capped_prefix *)state)->len;
+}
+
+static const char *php_rocksdb_capped_prefix_name(void *state) {
+  return ((php_rocksdb_capped_prefix *)state)->name;
+}
+
+static rocksdb_slicetransform_t *php_rocksdb_capped_prefix_create(size_t len) {
+  php_rocksdb_capped_prefix *cp = malloc(sizeof(php_rocksdb_capped_prefix));
+  cp->len = len;
+  /* Same name as RocksDB's CappedPrefixTransform so SST prefix filters stay
+     usable from other tools opening the DB. */
+  snprintf(cp->name, sizeof(cp->name), "rocksdb.CappedPrefix.%zu", len);
+  return rocksdb_slicetransform_create(cp, free,
+    php_rocksdb_capped_prefix_transform,
+    php_rocksdb_capped_prefix_in_domain,
+    php_rocksdb_capped_prefix_in_range,
+    php_rocksdb_capped_prefix_name);
+}
+
+/* Parses 'prefix_extractor' => int (fixed length) or
+   ['type' => 'fixed'|'capped', 'length' => int]. */
+static zend_bool php_rocksdb_parse_prefix_extractor(zval *val, int *kind, size_t *len) {
+  zend_long length = 0;
+
+  *kind = PHP_ROCKSDB_PREFIX_FIXED;
+  if (Z_TYPE_P(val) == IS_ARRAY) {
+    zval *entry;
+    if ((entry = zend_hash_str_find(Z_ARRVAL_P(val), "type", sizeof("type") - 1)) != NULL) {
+      zend_string *type = zval_get_string(entry);
+      if (zend_string_equals_literal(type, "capped")) {
+        *kind = PHP_ROCKSDB_PREFIX_CAPPED;
+      } else if (!zend_string_equals_literal(type, "fixed")) {
+        zend_string_release(type);
+        return 0;
+      }
+      zend_string_release(type);
+    }
+    if ((entry = zend_hash_str_find(Z_ARRVAL_P(val), "length", sizeof("length") - 1)) != NULL) {
+      length = zval_get_long(entry);
+    }
+  } else {
+    length = zval_get_long(val);
+  }
+  if (length <= 0) {
+    return 0;
+  }
+  *len = (size_t)length;
+  return 1;
+}
+
+/* Built-in merge operators. Numeric ones keep values as decimal int64
+   strings, so get() returns them as-is; like RocksDB's own UInt64Add, a
+   malformed value counts as 0 for add and is skipped by max/min. */
+typedef struct _php_rocksdb_merge_op {
+  int kind;                      /* PHP_ROCKSDB_MERGE_* */
+  char *delimiter;
+  size_t delimiter_len;
+  zend_bool expiry;              /* stored values carry an expiry header */
+} php_rocksdb_merge_op;
+
+static zend_bool php_rocksdb_merge_parse_int(const char *s, size_t len, int64_t *out) {
+  char buf[24], *end;
+
+  if (len == 0 || len >= sizeof(buf)) {
+    return 0;
+  }
+  memcpy(buf, s, len);
+  buf[len] = '\0';
+  errno = 0;
+  *out = (int64_t)strtoll(buf, &end, 10);
+  return errno == 0 && *end == '\0';
+}
+
+static char *php_rocksdb_merge_format_int(int64_t v, size_t *len) {
+  char *out = malloc(24);
+  *len = (size_t)snprintf(out, 24, "%" PRId64, v);
+  return out;
+}
+
+/* Folds 'num' operands (plus the existing value on a full merge) into one */
+static char *php_rocksdb_merge_fold(php_rocksdb_merge_op *op, zend_bool full,
+    const char *existing, size_t existing_len,
+    const char *const *operands, const size_t *operand_lens, int num,
+    unsigned char *success, size_t *new_len) {
+  int i;
+  int64_t acc = 0, v;
+  zend_bool have = 0;
+
+  *success = 1;
+  if (op->kind == PHP_ROCKSDB_MERGE_APPEND) {
+    size_t total = existing ? existing_len : 0, off = 0;
+    char *out;
+    for (i = 0; i < num; i++) {
+      total += operand_lens[i] + ((existing || i > 0) ? op->delimiter_len : 0);
+    }
+    out = malloc(total ? total : 1);
+    if (existing) {
+      memcpy(out, existing, existing_len);
+      off = existing_len;
+    }
+    for (i = 0; i < num; i++) {
+      if (existing || i > 0) {
+        memcpy(out + off, op->delimiter, op->delimiter_len);
+        off += op->delimiter_len;
+      }
+      memcpy(out + off, operands[i], operand_lens[i]);
+      off += operand_lens[i];
+    }
+    *new_len = total;
+    return out;
+  }
+
+  if (existing && php_rocksdb_merge_parse_int(existing, existing_len, &v)) {
+    acc = v;
+    have = 1;
+  }
+  for (i = 0; i < num; i++) {
+    if (!php_rocksdb_merge_parse_int(operands[i], operand_lens[i], &v)) {
+      continue;
+    }
+    if (op->kind == PHP_ROCKSDB_MERGE_ADD) {
+      acc = (int64_t)((uint64_t)acc + (uint64_t)v);
+    } else if (!have || (op->kind == PHP_ROCKSDB_MERGE_MAX ? v > acc : v < acc)) {
+      acc = v;
+    }
+    have = 1;
+  }
+  if (!have && op->kind != PHP_ROCKSDB_MERGE_ADD) {
+    char *out;
+    if (!full) {
+      /* Nothing to combine; RocksDB keeps the operands as they are */
+      *success = 0;
+      *new_len = 0;
+      return NULL;
+    }
+    /* Nothing usable to compare: keep the stored value (if any) untouched */
+    out = malloc(existing_len ? existing_len : 1);
+    if (existing) {
+      memcpy(out, existing, existing_len);
+    }
+    *new_len = existing ? existing_len : 0;
+    return out;
+  }
+  return php_rocksdb_merge_format_int(acc, new_len);
+}
+
+/* Under 'expiry_filter' the operands fold into the existing value without
+   its header, and the result keeps it; an expired value counts as absent. */
+static char *php_rocksdb_merge_full(void *state, const char *key, size_t key_len,
+    const char *existing, size_t existing_len,
+    const char *const *operands, const size_t *operand_lens, int num,
+    unsigned char *success, size_t *new_len) {
+  php_rocksdb_merge_op *op = state;
+  const char *header = NULL;
+  uint64_t expires_at;
+  char *out, *framed;
+
+  if (op->expiry && existing && php_rocksdb_expiry_parse(existing, existing_len, &expires_at)) {
+    if (php_rocksdb_expiry_expired(expires_at, (uint64_t)time(NULL))) {
+      existing = NULL;
+      existing_len = 0;
+    } else {
+      header = existing;
+      existing += PHP_ROCKSDB_EXPIRY_HEADER_LEN;
+      existing_len -= PHP_ROCKSDB_EXPIRY_HEADER_LEN;
+    }
+  }
+  out = php_rocksdb_merge_fold(op, 1, existing, existing_len,
+    operands, operand_lens, num, success, new_len);
+  if (!header || !out) {
+    return out;
+  }
+  framed = malloc(PHP_ROCKSDB_EXPIRY_HEADER_LEN + *new_len);
+  memcpy(framed, header, PHP_ROCKSDB_EXPIRY_HEADER_LEN);
+  memcpy(framed + PHP_ROCKSDB_EXPIRY_HEADER_LEN, out, *new_len);
+  *new_len += PHP_ROCKSDB_EXPIRY_HEADER_LEN;
+  free(out);
+  return framed;
+}
+
+static char *php_rocksdb_merge_partial(void *state, const char *key, size_t key_len,
+    const char *const *operands, const size_t *operand_lens, int num,
+    unsigned char *success, size_t *new_len) {
+  return php_rocksdb_merge_fold(state, 0, NULL, 0,
+    operands, operand_lens, num, success, new_len);
+}
+
+static void php_rocksdb_merge_delete_value(void *state, const char *value, size_t len) {
+  free((char *)value);
+}
+
+static const char *php_rocksdb_merge_name(void *state) {
+  switch (((php_rocksdb_merge_op *)state)->kind) {
+    case PHP_ROCKSDB_MERGE_ADD: return "php-rocksdb.add";
+    case PHP_ROCKSDB_MERGE_MAX: return "php-rocksdb.max";
+    case PHP_ROCKSDB_MERGE_MIN: return "php-rocksdb.min";
+    default:                    return "php-rocksdb.append";
+  }
+}
+
+static void php_rocksdb_merge_op_destroy(void *state) {
+  php_rocksdb_merge_op *op = state;
+  free(op->delimiter);
+  free(op);
+}
+
+/* Compaction filter behind 'expiry_filter'. Stateless, so the factory
+   hands every compaction a fresh one that RocksDB owns and frees. */
+static unsigned char php_rocksdb_expiry_filter(void *state, int level,
+    const char *key, size_t key_len, const char *value, size_t value_len,
+    char **new_value, size_t *new_value_len, unsigned char *value_changed) {
+  uint64_t expires_at;
+
+  *value_changed = 0;
+  return php_rocksdb_expiry_parse(value, value_len, &expires_at)
+    && php_rocksdb_expiry_expired(expires_at, (uint64_t)time(NULL));
+}
+
+static const char *php_rocksdb_expiry_filter_name(void *state) {
+  return "php-rocksdb.expiry";
+}
+
+static void php_rocksdb_expiry_filter_destroy(void *state) {
+}
+
+static rocksdb_compactionfilter_t *php_rocksdb_expiry_filter_create(void *state,
+    rocksdb_compactionfiltercontext_t *context) {
+  return rocksdb_compactionfilter_create(NULL, php_rocksdb_expiry_filter_destroy,
+    php_rocksdb_expiry_filter, php_rocksdb_expiry_filter_name);
+}
+
+/* Parses 'merge_operator' => 'add'|'max'|'min'|'append' or
+   ['type' => 'append', 'delimiter' => ',']. Returns NULL on a bad value. */
+static rocksdb_mergeoperator_t *php_rocksdb_parse_merge_operator(zval *val, zend_bool expiry) {
+  zend_string *type;
+  const char *delimiter = ",";
+  size_t delimiter_len = 1;
+  zval *entry, *type_zv = val;
+  php_rocksdb_merge_op *op;
+  int kind;
+
+  if (Z_TYPE_P(val) == IS_ARRAY) {
+    type_zv = zend_hash_str_find(Z_ARRVAL_P(val), "type", sizeof("type") - 1);
+    if (!type_zv) {
+      return NULL;
     }
+    if ((entry = zend_hash_str_find(Z_ARRVAL_P(val), "delimiter", sizeof("delimiter") - 1)) != NULL) {
+      if (Z_TYPE_P(entry) != IS_STRING) {
+        return NULL;
+      }
+      delimiter = Z_STRVAL_P(entry);
+      delimiter_len = Z_STRLEN_P(entry);
+    }
+  }
+  type = zval_get_string(type_zv);
+  if (zend_string_equals_literal(type, "add")) {
+    kind = PHP_ROCKSDB_MERGE_ADD;
+  } else if (zend_string_equals_literal(type, "max")) {
+    kind = PHP_ROCKSDB_MERGE_MAX;
+  } else if (zend_string_equals_literal(type, "min")) {
+    kind = PHP_ROCKSDB_MERGE_MIN;
+  } else if (zend_string_equals_literal(type, "append")) {
+    kind = PHP_ROCKSDB_MERGE_APPEND;
+  } else {
+    zend_string_release(type);
+    return NULL;
+  }
+  zend_string_release(type);
+
+  op = malloc(sizeof(php_rocksdb_merge_op));
+  op->kind = kind;
+  op->expiry = expiry;
+  op->delimiter_len = delimiter_len;
+  op->delimiter = malloc(delimiter_len ? delimiter_len : 1);
+  memcpy(op->delimiter, delimiter, delimiter_len);
+  return rocksdb_mergeoperator_create(op, php_rocksdb_merge_op_destroy,
+    php_rocksdb_merge_full, php_rocksdb_merge_partial,
+    php_rocksdb_merge_delete_value, php_rocksdb_merge_name);
+}
+
+/* Applies the memtable, compaction, compression and block-based table
+   settings of an options array (may be NULL) to 'options'. Shared by the
+   DB and its column families. Returns 0 with an exception set on a bad
+   value. */
+static zend_bool php_rocksdb_options_apply(rocksdb_options_t *options, HashTable *ht,
+    php_rocksdb_cache *block_cache, int *prefix_extractor, size_t *prefix_extractor_len) {
+  rocksdb_block_based_table_options_t *table_opts = rocksdb_block_based_options_create();
+  zval *val;
+
+  if (block_cache) {
+    rocksdb_block_based_options_set_block_cache(table_opts, block_cache->cache);
+  }
+
+  if (ht) {
     if ((val = zend_hash_str_find(ht, "write_buffer_size", sizeof("write_buffer_size") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_write_buffer_size(obj->options, (size_t)Z_LVAL_P(val));
+      rocksdb_options_set_write_buffer_size(options, (size_t)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "max_write_buffer_number", sizeof("max_write_buffer_number") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_max_write_buffer_number(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_max_write_buffer_number(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "min_write_buffer_number_to_merge", sizeof("min_write_buffer_number_to_merge") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_min_write_buffer_number_to_merge(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_min_write_buffer_number_to_merge(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "max_background_jobs", sizeof("max_background_jobs") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_max_background_jobs(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_max_background_jobs(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "max_background_compactions", sizeof("max_background_compactions") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_max_background_compactions(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_max_background_compactions(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "max_open_files", sizeof("max_open_files") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_max_open_files(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_max_open_files(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "target_file_size_base", sizeof("target_file_size_base") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_target_file_size_base(obj->options, (uint64_t)Z_LVAL_P(val));
+      rocksdb_options_set_target_file_size_base(options, (uint64_t)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "max_bytes_for_level_base", sizeof("max_bytes_for_level_base") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_max_bytes_for_level_base(obj->options, (uint64_t)Z_LVAL_P(val));
+      rocksdb_options_set_max_bytes_for_level_base(options, (uint64_t)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "compression", sizeof("compression") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_compression(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_compression(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "bottommost_compression", sizeof("bottommost_compression") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_bottommost_compression(obj->options, (int)Z_LVAL_P(val));
+      rocksdb_options_set_bottommost_compression(options, (int)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "bloom_locality", sizeof("bloom_locality") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_bloom_locality(obj->options, (uint32_t)Z_LVAL_P(val));
+      rocksdb_options_set_bloom_locality(options, (uint32_t)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "memtable_prefix_bloom_size_ratio", sizeof("memtable_prefix_bloom_size_ratio") - 1)) != NULL) {
       convert_to_double(val);
-      rocksdb_options_set_memtable_prefix_bloom_size_ratio(obj->options, Z_DVAL_P(val));
+      rocksdb_options_set_memtable_prefix_bloom_size_ratio(options, Z_DVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "block_size", sizeof("block_size") - 1)) != NULL) {
       convert_to_long(val);
@@ -344,454 +1593,4992 @@ PHP_METHOD(RocksDB, __construct)
       convert_to_long(val);
       rocksdb_block_based_options_set_block_restart_interval(table_opts, (int)Z_LVAL_P(val));
     }
+    if ((val = zend_hash_str_find(ht, "cache_index_and_filter_blocks", sizeof("cache_index_and_filter_blocks") - 1)) != NULL) {
+      rocksdb_block_based_options_set_cache_index_and_filter_blocks(table_opts, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(ht, "pin_l0_filter_and_index_blocks_in_cache", sizeof("pin_l0_filter_and_index_blocks_in_cache") - 1)) != NULL) {
+      rocksdb_block_based_options_set_pin_l0_filter_and_index_blocks_in_cache(table_opts, zend_is_true(val));
+    }
+
+    /* Filters: full bloom or ribbon, plus prefix blooms via the extractor */
+    if ((val = zend_hash_str_find(ht, "bloom_bits_per_key", sizeof("bloom_bits_per_key") - 1)) != NULL) {
+      double bits = zval_get_double(val);
+      zend_long filter_type = PHP_ROCKSDB_BLOOM_FILTER;
+      zval *type_zv;
+      if ((type_zv = zend_hash_str_find(ht, "filter_type", sizeof("filter_type") - 1)) != NULL) {
+        filter_type = zval_get_long(type_zv);
+      }
+      if (bits > 0) {
+        rocksdb_block_based_options_set_filter_policy(table_opts,
+          filter_type == PHP_ROCKSDB_RIBBON_FILTER
+            ? rocksdb_filterpolicy_create_ribbon(bits)
+            : rocksdb_filterpolicy_create_bloom_full(bits));
+      }
+    }
+    if ((val = zend_hash_str_find(ht, "whole_key_filtering", sizeof("whole_key_filtering") - 1)) != NULL) {
+      rocksdb_block_based_options_set_whole_key_filtering(table_opts, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(ht, "prefix_extractor", sizeof("prefix_extractor") - 1)) != NULL) {
+      if (!php_rocksdb_parse_prefix_extractor(val, prefix_extractor, prefix_extractor_len)) {
+        rocksdb_block_based_options_destroy(table_opts);
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'prefix_extractor' must be a positive length or ['type' => 'fixed'|'capped', 'length' => int]", 0);
+        return 0;
+      }
+      rocksdb_options_set_prefix_extractor(options,
+        *prefix_extractor == PHP_ROCKSDB_PREFIX_CAPPED
+          ? php_rocksdb_capped_prefix_create(*prefix_extractor_len)
+          : rocksdb_slicetransform_create_fixed_prefix(*prefix_extractor_len));
+    }
+
+    if ((val = zend_hash_str_find(ht, "merge_operator", sizeof("merge_operator") - 1)) != NULL) {
+      zval *expiry = zend_hash_str_find(ht, "expiry_filter", sizeof("expiry_filter") - 1);
+      rocksdb_mergeoperator_t *merge_op = php_rocksdb_parse_merge_operator(val,
+        expiry && zend_is_true(expiry));
+      if (!merge_op) {
+        rocksdb_block_based_options_destroy(table_opts);
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'merge_operator' must be 'add', 'max', 'min', 'append' or ['type' => 'append', 'delimiter' => string]", 0);
+        return 0;
+      }
+      rocksdb_options_set_merge_operator(options, merge_op);
+    }
+
+    if ((val = zend_hash_str_find(ht, "expiry_filter", sizeof("expiry_filter") - 1)) != NULL
+        && zend_is_true(val)) {
+      /* The options keep the factory alive */
+      rocksdb_options_set_compaction_filter_factory(options,
+        rocksdb_compactionfilterfactory_create(NULL, php_rocksdb_expiry_filter_destroy,
+          php_rocksdb_expiry_filter_create, php_rocksdb_expiry_filter_name));
+    }
 
     /* Additions: bulk/online control knobs */
     if ((val = zend_hash_str_find(ht, "disable_auto_compactions", sizeof("disable_auto_compactions") - 1)) != NULL) {
-      rocksdb_options_set_disable_auto_compactions(obj->options, zend_is_true(val));
+      rocksdb_options_set_disable_auto_compactions(options, zend_is_true(val));
     }
     if ((val = zend_hash_str_find(ht, "level_compaction_dynamic_level_bytes", sizeof("level_compaction_dynamic_level_bytes") - 1)) != NULL) {
-      rocksdb_options_set_level_compaction_dynamic_level_bytes(obj->options, zend_is_true(val));
+      rocksdb_options_set_level_compaction_dynamic_level_bytes(options, zend_is_true(val));
     }
     if ((val = zend_hash_str_find(ht, "max_subcompactions", sizeof("max_subcompactions") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_max_subcompactions(obj->options, (uint32_t)Z_LVAL_P(val));
+      rocksdb_options_set_max_subcompactions(options, (uint32_t)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "bytes_per_sync", sizeof("bytes_per_sync") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_bytes_per_sync(obj->options, (uint64_t)Z_LVAL_P(val));
+      rocksdb_options_set_bytes_per_sync(options, (uint64_t)Z_LVAL_P(val));
     }
     if ((val = zend_hash_str_find(ht, "wal_bytes_per_sync", sizeof("wal_bytes_per_sync") - 1)) != NULL) {
       convert_to_long(val);
-      rocksdb_options_set_wal_bytes_per_sync(obj->options, (uint64_t)Z_LVAL_P(val));
+      rocksdb_options_set_wal_bytes_per_sync(options, (uint64_t)Z_LVAL_P(val));
     }
   }
 
-  rocksdb_options_set_block_based_table_factory(obj->options, table_opts);
+  rocksdb_options_set_block_based_table_factory(options, table_opts);
   rocksdb_block_based_options_destroy(table_opts);
+  return 1;
+}
 
-  obj->read_options = rocksdb_readoptions_create();
-  obj->write_options = rocksdb_writeoptions_create();
-
-  if (read_only) {
-    obj->db = rocksdb_open_for_read_only(obj->options, path,
-      /* error_if_log_file_exist */ 0, &err);
-  } else {
-    obj->db = rocksdb_open(obj->options, path, &err);
+/* Options for one column family: the top-level options array (may be NULL)
+   overlaid with the family's own. A 'block_cache'/'block_cache_size' of its
+   own keeps the family out of the DB-wide block cache. Returns NULL with an
+   exception set on a bad value. */
+static rocksdb_options_t *php_rocksdb_column_family_options(HashTable *db_ht,
+    zval *cf_zv, php_rocksdb_cache *db_cache, php_rocksdb_column_family *cf) {
+  HashTable *merged = db_ht ? zend_array_dup(db_ht) : zend_new_array(0);
+  rocksdb_options_t *options = NULL;
+  zend_bool failed = 0;
+
+  if (cf_zv && Z_TYPE_P(cf_zv) == IS_ARRAY) {
+    zend_hash_merge(merged, Z_ARRVAL_P(cf_zv), zval_add_ref, 1);
+    cf->block_cache = php_rocksdb_cache_from_options(Z_ARRVAL_P(cf_zv),
+      "block_cache", sizeof("block_cache") - 1,
+      "block_cache_size", sizeof("block_cache_size") - 1, &failed);
+  } else if (cf_zv && Z_TYPE_P(cf_zv) != IS_NULL) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Options for column family '%s' must be an array", cf->name);
+    failed = 1;
   }
-  ROCKSDB_CHECK_ERROR(err);
+  if (!failed) {
+    if (!cf->block_cache && db_cache) {
+      db_cache->refcount++;
+      cf->block_cache = db_cache;
+    }
+    options = rocksdb_options_create();
+    if (!php_rocksdb_options_apply(options, merged, cf->block_cache,
+        &cf->prefix_extractor, &cf->prefix_extractor_len)) {
+      rocksdb_options_destroy(options);
+      options = NULL;
+    }
+  }
+  zend_array_destroy(merged);
+  return options;
 }
 
-/* public function RocksDB::compactRange(?string $begin = null, ?string $end = null): bool */
-PHP_METHOD(RocksDB, compactRange)
-{
-  char *begin = NULL, *end = NULL;
-  size_t blen = 0, elen = 0;
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|s!s!", &begin, &blen, &end, &elen) == FAILURE) {
-    return;
+/* Lock settings of a pessimistic TransactionDB, from 'transaction_db_options':
+   lock_timeout (ms a transaction waits for a key lock), default_lock_timeout
+   (ms for writes outside a transaction), max_num_locks, num_stripes */
+static rocksdb_transactiondb_options_t *php_rocksdb_transactiondb_options(HashTable *ht) {
+  rocksdb_transactiondb_options_t *txn_db_options = rocksdb_transactiondb_options_create();
+  zval *opts, *val;
+
+  opts = ht ? zend_hash_str_find(ht, "transaction_db_options",
+    sizeof("transaction_db_options") - 1) : NULL;
+  if (!opts || Z_TYPE_P(opts) != IS_ARRAY) {
+    return txn_db_options;
   }
-  rocksdb_object *obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
-  /* Correct C API call (no read_options parameter) */
-  rocksdb_compact_range(obj->db, begin, blen, end, elen);
-  RETURN_TRUE;
+  if ((val = zend_hash_str_find(Z_ARRVAL_P(opts), "lock_timeout", sizeof("lock_timeout") - 1)) != NULL) {
+    rocksdb_transactiondb_options_set_transaction_lock_timeout(txn_db_options, zval_get_long(val));
+  }
+  if ((val = zend_hash_str_find(Z_ARRVAL_P(opts), "default_lock_timeout", sizeof("default_lock_timeout") - 1)) != NULL) {
+    rocksdb_transactiondb_options_set_default_lock_timeout(txn_db_options, zval_get_long(val));
+  }
+  if ((val = zend_hash_str_find(Z_ARRVAL_P(opts), "max_num_locks", sizeof("max_num_locks") - 1)) != NULL) {
+    rocksdb_transactiondb_options_set_max_num_locks(txn_db_options, zval_get_long(val));
+  }
+  if ((val = zend_hash_str_find(Z_ARRVAL_P(opts), "num_stripes", sizeof("num_stripes") - 1)) != NULL) {
+    zend_long stripes = zval_get_long(val);
+    if (stripes > 0) {
+      rocksdb_transactiondb_options_set_num_stripes(txn_db_options, (size_t)stripes);
+    }
+  }
+  return txn_db_options;
 }
 
-/* public function RocksDB::get(string $key): string|false */
-PHP_METHOD(RocksDB, get)
-{
-  char *key;
-  size_t key_len;
+/* Opens the DB with every column family it already has plus the ones listed
+   under 'column_families' (name => options, or just a name), creating the
+   missing ones unless read-only or secondary, and registers the handles in
+   obj->column_families. 'mode' is a PHP_ROCKSDB_OPEN_* value. Returns 0
+   with an exception set on failure. */
+static zend_bool php_rocksdb_open(rocksdb_object *obj, const char *path,
+    HashTable *ht, int mode) {
+  HashTable names;
+  zval *configured = ht
+    ? zend_hash_str_find(ht, "column_families", sizeof("column_families") - 1) : NULL;
+  zval null_zv, *val;
+  zend_string *name;
+  char **existing;
+  size_t num_existing = 0;
+  uint32_t n, i = 0, j;
+  const char **cf_names;
+  rocksdb_options_t **cf_options;
+  rocksdb_column_family_handle_t **handles;
+  php_rocksdb_column_family **cfs;
   char *err = NULL;
-  size_t val_len;
-  rocksdb_object *obj;
-  char *val;
+  zend_bool ok = 1;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
-    return;
+  if (configured && Z_TYPE_P(configured) != IS_ARRAY) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Option 'column_families' must be an array", 0);
+    return 0;
   }
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
 
-  val = rocksdb_get(obj->db, obj->read_options, key, key_len, &val_len, &err);
-  ROCKSDB_CHECK_ERROR(err);
-
-  if (!val) {
-    RETURN_NULL();
+  /* Every existing family must be opened; the default one comes first */
+  ZVAL_NULL(&null_zv);
+  zend_hash_init(&names, 8, NULL, NULL, 0);
+  zend_hash_str_add(&names, "default", sizeof("default") - 1, &null_zv);
+  existing = rocksdb_list_column_families(obj->options, path, &num_existing, &err);
+  if (err != NULL) {
+    /* No DB there yet */
+    rocksdb_free(err);
+    err = NULL;
+  } else if (existing) {
+    size_t k;
+    for (k = 0; k < num_existing; k++) {
+      zend_hash_str_add(&names, existing[k], strlen(existing[k]), &null_zv);
+    }
+    rocksdb_list_column_families_destroy(existing, num_existing);
+  }
+  if (configured) {
+    ZEND_HASH_FOREACH_STR_KEY_VAL(Z_ARRVAL_P(configured), name, val) {
+      if (name) {
+        zend_hash_update(&names, name, val);
+      } else if (Z_TYPE_P(val) == IS_STRING) {
+        zend_hash_update(&names, Z_STR_P(val), &null_zv);
+      } else {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'column_families' must map names to option arrays or list names", 0);
+        zend_hash_destroy(&names);
+        return 0;
+      }
+    } ZEND_HASH_FOREACH_END();
   }
-  RETVAL_STRINGL(val, val_len);
-  rocksdb_free(val);
-}
-
-/* public function RocksDB::multiGet(array $keys): array */
-PHP_METHOD(RocksDB, multiGet)
-{
-  zval *keys_zv; HashTable *ht;
-  size_t n, i = 0;
-  const char **c_keys; size_t *c_key_lens, *c_val_lens;
-  char **c_vals, **c_errs;
-  rocksdb_object *obj;
-
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &keys_zv) == FAILURE) return;
-
-  ht = Z_ARRVAL_P(keys_zv);
-  n  = zend_hash_num_elements(ht);
-  if (!n) { array_init(return_value); return; }
 
-  c_keys     = emalloc(sizeof(char*)  * n);
-  c_key_lens = emalloc(sizeof(size_t) * n);
-  c_vals     = ecalloc(n, sizeof(char*));
-  c_val_lens = emalloc(sizeof(size_t) * n);
-  c_errs     = ecalloc(n, sizeof(char*));
+  n = zend_hash_num_elements(&names);
+  cf_names = emalloc(sizeof(char*) * n);
+  cf_options = ecalloc(n, sizeof(rocksdb_options_t*));
+  handles = ecalloc(n, sizeof(rocksdb_column_family_handle_t*));
+  cfs = ecalloc(n, sizeof(php_rocksdb_column_family*));
 
-  zval *zv;
-  ZEND_HASH_FOREACH_VAL(ht, zv) {
-    convert_to_string(zv);
-    c_keys[i]     = Z_STRVAL_P(zv);
-    c_key_lens[i] = Z_STRLEN_P(zv);
+  ZEND_HASH_FOREACH_STR_KEY_VAL(&names, name, val) {
+    cfs[i] = php_rocksdb_column_family_create(ZSTR_VAL(name));
+    cf_names[i] = cfs[i]->name;
+    cf_options[i] = php_rocksdb_column_family_options(ht, val, obj->block_cache, cfs[i]);
     i++;
-  } ZEND_HASH_FOREACH_END();
-
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
-  rocksdb_multi_get(obj->db, obj->read_options,
-                    n, c_keys, c_key_lens,
-                    c_vals, c_val_lens, c_errs);
-
-  array_init_size(return_value, n);
-  for (i = 0; i < n; i++) {
-    if (c_errs[i]) {
-      add_next_index_bool(return_value, 0);
-      rocksdb_free(c_errs[i]);
-    } else if (c_vals[i]) {
-      add_next_index_stringl(return_value, c_vals[i], c_val_lens[i]);
-      rocksdb_free(c_vals[i]);
-    } else {
-      add_next_index_null(return_value);
+    if (!cf_options[i - 1]) {
+      ok = 0;
+      break;
     }
+  } ZEND_HASH_FOREACH_END();
+  zend_hash_destroy(&names);
+
+  if (ok) {
+    if (mode == PHP_ROCKSDB_OPEN_READ_ONLY) {
+      obj->db = rocksdb_open_for_read_only_column_families(obj->options, path,
+        (int)n, cf_names, (const rocksdb_options_t* const*)cf_options, handles,
+        /* error_if_wal_file_exists */ 0, &err);
+    } else if (mode == PHP_ROCKSDB_OPEN_SECONDARY) {
+      zval *secondary_path = zend_hash_str_find(ht, "secondary_path", sizeof("secondary_path") - 1);
+      obj->db = rocksdb_open_as_secondary_column_families(obj->options, path,
+        Z_STRVAL_P(secondary_path), (int)n, cf_names,
+        (const rocksdb_options_t* const*)cf_options, handles, &err);
+    } else if (mode == PHP_ROCKSDB_OPEN_TTL) {
+      /* One TTL for every family */
+      int *ttls = safe_emalloc(n, sizeof(int), 0);
+      int ttl = (int)zval_get_long(zend_hash_str_find(ht, "ttl", sizeof("ttl") - 1));
+      for (j = 0; j < n; j++) {
+        ttls[j] = ttl;
+      }
+      rocksdb_options_set_create_missing_column_families(obj->options, 1);
+      obj->db = rocksdb_open_column_families_with_ttl(obj->options, path,
+        (int)n, cf_names, (const rocksdb_options_t* const*)cf_options, handles, ttls, &err);
+      efree(ttls);
+    } else if (mode == PHP_ROCKSDB_OPEN_PESSIMISTIC) {
+      rocksdb_transactiondb_options_t *txn_db_options = php_rocksdb_transactiondb_options(ht);
+      rocksdb_options_set_create_missing_column_families(obj->options, 1);
+      obj->txn_db = rocksdb_transactiondb_open_column_families(obj->options, txn_db_options,
+        path, (int)n, cf_names, (const rocksdb_options_t* const*)cf_options, handles, &err);
+      rocksdb_transactiondb_options_destroy(txn_db_options);
+      if (obj->txn_db) {
+        obj->db = rocksdb_transactiondb_get_base_db(obj->txn_db);
+      }
+    } else if (mode == PHP_ROCKSDB_OPEN_OPTIMISTIC) {
+      rocksdb_options_set_create_missing_column_families(obj->options, 1);
+      obj->otxn_db = rocksdb_optimistictransactiondb_open_column_families(obj->options,
+        path, (int)n, cf_names, (const rocksdb_options_t* const*)cf_options, handles, &err);
+      if (obj->otxn_db) {
+        obj->db = rocksdb_optimistictransactiondb_get_base_db(obj->otxn_db);
+      }
+    } else {
+      rocksdb_options_set_create_missing_column_families(obj->options, 1);
+      obj->db = rocksdb_open_column_families(obj->options, path,
+        (int)n, cf_names, (const rocksdb_options_t* const*)cf_options, handles, &err);
+    }
+    ok = err == NULL;
+  }
+
+  if (ok) {
+    obj->column_families = pemalloc(sizeof(HashTable), 1);
+    zend_hash_init(obj->column_families, n, NULL, php_rocksdb_column_family_dtor, 1);
+    /* The default family's settings drive iterators opened without one */
+    obj->prefix_extractor = cfs[0]->prefix_extractor;
+    obj->prefix_extractor_len = cfs[0]->prefix_extractor_len;
+  }
+  for (j = 0; j < i; j++) {
+    if (cf_options[j]) {
+      rocksdb_options_destroy(cf_options[j]);
+    }
+    if (ok) {
+      cfs[j]->handle = handles[j];
+      zend_hash_str_update_ptr(obj->column_families, cfs[j]->name,
+        strlen(cfs[j]->name), cfs[j]);
+    } else {
+      php_rocksdb_column_family_release(cfs[j]);
+    }
+  }
+  efree(cf_names);
+  efree(cf_options);
+  efree(handles);
+  efree(cfs);
+
+  if (err != NULL) {
+    zend_throw_exception(php_rocksdb_exception_ce, err, 0);
+    rocksdb_free(err);
+  }
+  return ok;
+}
+
+static void php_rocksdb_add_cache_stats(zval *arr, const char *name, php_rocksdb_cache *c) {
+  zval stats;
+  array_init_size(&stats, 3);
+  add_assoc_long(&stats, "capacity", (zend_long)rocksdb_cache_get_capacity(c->cache));
+  add_assoc_long(&stats, "usage", (zend_long)rocksdb_cache_get_usage(c->cache));
+  add_assoc_long(&stats, "pinned_usage", (zend_long)rocksdb_cache_get_pinned_usage(c->cache));
+  add_assoc_zval(arr, name, &stats);
+}
+
+/* Parses Statistics::ToString() output into
+   ['tickers' => [name => int], 'histograms' => [name => [p50, p95, p99, max, count, sum]]].
+   Ticker lines are "name COUNT : n"; histogram lines are
+   "name P50 : x P95 : x P99 : x P100 : x COUNT : n SUM : n". */
+static void php_rocksdb_parse_statistics(zval *arr, const char *s) {
+  zval tickers, histograms;
+
+  array_init(&tickers);
+  array_init(&histograms);
+
+  while (*s) {
+    const char *eol = strchr(s, '\n'), *p;
+    size_t name_len;
+    zval hist;
+
+    if (!eol) {
+      eol = s + strlen(s);
+    }
+    p = memchr(s, ' ', eol - s);
+    if (p) {
+      name_len = p - s;
+      ZVAL_UNDEF(&hist);
+      while (p < eol) {
+        const char *label;
+        size_t label_len;
+        char *end;
+
+        while (p < eol && *p == ' ') {
+          p++;
+        }
+        label = p;
+        while (p < eol && *p != ' ') {
+          p++;
+        }
+        label_len = p - label;
+        while (p < eol && (*p == ' ' || *p == ':')) {
+          p++;
+        }
+        if (!label_len || p >= eol) {
+          break;
+        }
+
+        if (label_len == 5 && memcmp(label, "COUNT", 5) == 0) {
+          zend_long n = (zend_long)strtoull(p, &end, 10);
+          if (Z_TYPE(hist) == IS_UNDEF) {
+            add_assoc_long_ex(&tickers, s, name_len, n);
+          } else {
+            add_assoc_long(&hist, "count", n);
+          }
+        } else if (label_len == 3 && memcmp(label, "SUM", 3) == 0) {
+          zend_long n = (zend_long)strtoull(p, &end, 10);
+          if (Z_TYPE(hist) != IS_UNDEF) {
+            add_assoc_long(&hist, "sum", n);
+          }
+        } else {
+          double d = strtod(p, &end);
+          if (Z_TYPE(hist) == IS_UNDEF) {
+            array_init_size(&hist, 6);
+          }
+          if (label_len == 3 && memcmp(label, "P50", 3) == 0) {
+            add_assoc_double(&hist, "p50", d);
+          } else if (label_len == 3 && memcmp(label, "P95", 3) == 0) {
+            add_assoc_double(&hist, "p95", d);
+          } else if (label_len == 3 && memcmp(label, "P99", 3) == 0) {
+            add_assoc_double(&hist, "p99", d);
+          } else if (label_len == 4 && memcmp(label, "P100", 4) == 0) {
+            add_assoc_double(&hist, "max", d);
+          }
+        }
+        if (end == p) {
+          break;
+        }
+        p = end;
+      }
+      if (Z_TYPE(hist) != IS_UNDEF) {
+        add_assoc_zval_ex(&histograms, s, name_len, &hist);
+      }
+    }
+    s = *eol ? eol + 1 : eol;
+  }
+
+  array_init_size(arr, 2);
+  add_assoc_zval(arr, "tickers", &tickers);
+  add_assoc_zval(arr, "histograms", &histograms);
+}
+
+/* Parses PerfContext::ToString() ("name = n, ...") into name => int; per-level
+   counters ("name = n@level0, m@level1") become name => [level => int] */
+static void php_rocksdb_parse_perf_report(zval *arr, const char *s) {
+  zval levels;
+  const char *name = NULL;
+  size_t name_len = 0;
+
+  array_init(arr);
+  ZVAL_UNDEF(&levels);
+
+  while (*s) {
+    const char *end = strstr(s, ", "), *eq, *at;
+
+    if (!end) {
+      end = s + strlen(s);
+    }
+    eq = php_memnstr(s, " = ", sizeof(" = ") - 1, end);
+    if (eq) {
+      if (Z_TYPE(levels) != IS_UNDEF) {
+        add_assoc_zval_ex(arr, name, name_len, &levels);
+        ZVAL_UNDEF(&levels);
+      }
+      name = s;
+      name_len = eq - s;
+      s = eq + sizeof(" = ") - 1;
+    }
+    at = php_memnstr(s, "@level", sizeof("@level") - 1, end);
+    if (at && name) {
+      if (Z_TYPE(levels) == IS_UNDEF) {
+        array_init(&levels);
+      }
+      add_index_long(&levels, (zend_ulong)strtoul(at + sizeof("@level") - 1, NULL, 10),
+        (zend_long)strtoull(s, NULL, 10));
+    } else if (eq) {
+      add_assoc_long_ex(arr, name, name_len, (zend_long)strtoull(s, NULL, 10));
+    }
+    s = *end ? end + 2 : end;
+  }
+  if (Z_TYPE(levels) != IS_UNDEF) {
+    add_assoc_zval_ex(arr, name, name_len, &levels);
+  }
+}
+
+static void php_rocksdb_perf_context(zval *arr, zend_bool exclude_zero) {
+  rocksdb_perfcontext_t *ctx = rocksdb_perfcontext_create();
+  char *report = rocksdb_perfcontext_report(ctx, exclude_zero);
+
+  php_rocksdb_parse_perf_report(arr, report);
+  rocksdb_free(report);
+  rocksdb_perfcontext_destroy(ctx);
+}
+
+/* The perf level is thread-local in RocksDB and outlives the request, so it
+   is mirrored in ROCKSDB_G(perf_level) for profile() and RSHUTDOWN */
+static zend_bool php_rocksdb_set_perf_level(zend_long level) {
+  if (level < rocksdb_disable || level > rocksdb_enable_time) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Invalid perf level " ZEND_LONG_FMT ", expected one of RocksDB::PERF_*", level);
+    return 0;
+  }
+  rocksdb_set_perf_level((int)level);
+  ROCKSDB_G(perf_level) = (int)level;
+  return 1;
+}
+
+/* Parses the text form of a map property ("k1=v1; k2=v2" or "k: v" lines);
+   numeric values come back as int/float */
+static void php_rocksdb_parse_map_property(zval *arr, const char *s) {
+  array_init(arr);
+
+  while (*s) {
+    size_t len = strcspn(s, ";\n");
+    const char *sep = memchr(s, '=', len);
+
+    if (!sep) {
+      sep = memchr(s, ':', len);
+    }
+    if (sep) {
+      const char *k = s, *kend = sep, *v = sep + 1, *vend = s + len;
+      zend_long lval;
+      double dval;
+
+      while (k < kend && (*k == ' ' || *k == '\t')) {
+        k++;
+      }
+      while (kend > k && (kend[-1] == ' ' || kend[-1] == '\t')) {
+        kend--;
+      }
+      while (v < vend && (*v == ' ' || *v == '\t')) {
+        v++;
+      }
+      while (vend > v && (vend[-1] == ' ' || vend[-1] == '\t' || vend[-1] == '\r')) {
+        vend--;
+      }
+      if (kend > k) {
+        switch (is_numeric_string(v, vend - v, &lval, &dval, 0)) {
+          case IS_LONG:
+            add_assoc_long_ex(arr, k, kend - k, lval);
+            break;
+          case IS_DOUBLE:
+            add_assoc_double_ex(arr, k, kend - k, dval);
+            break;
+          default:
+            add_assoc_stringl_ex(arr, k, kend - k, v, vend - v);
+        }
+      }
+    }
+    s += len;
+    if (*s) {
+      s++;
+    }
+  }
+}
+
+static void php_rocksdb_readoptions_dtor(zval *zv) {
+  rocksdb_readoptions_destroy(Z_PTR_P(zv));
+}
+
+static void php_rocksdb_writeoptions_dtor(zval *zv) {
+  rocksdb_writeoptions_destroy(Z_PTR_P(zv));
+}
+
+/* Finds the cached option object for a per-call array, keyed by its
+   signature; the cache is emptied rather than grown past its cap. */
+static void *php_rocksdb_options_cache_find(HashTable **cache, dtor_func_t dtor,
+    zval *options_zv, zend_string **key) {
+  smart_str buf = {0};
+  void *found;
+
+  php_rocksdb_options_signature(&buf, Z_ARRVAL_P(options_zv));
+  smart_str_0(&buf);
+  *key = buf.s;
+
+  if (!*cache) {
+    ALLOC_HASHTABLE(*cache);
+    zend_hash_init(*cache, 8, NULL, dtor, 0);
+  } else if ((found = zend_hash_find_ptr(*cache, *key)) != NULL) {
+    zend_string_release(*key);
+    return found;
+  } else if (zend_hash_num_elements(*cache) >= PHP_ROCKSDB_OPTIONS_CACHE_SIZE) {
+    zend_hash_clean(*cache);
+  }
+  return NULL;
+}
+
+/* Read options for one call: the instance's own when no (or an empty) array
+   is given, else the instance defaults overlaid with the array. */
+static rocksdb_readoptions_t *php_rocksdb_call_read_options(rocksdb_object *obj,
+    zval *options_zv) {
+  rocksdb_readoptions_t *ro;
+  zend_string *key;
+
+  if (!options_zv || zend_hash_num_elements(Z_ARRVAL_P(options_zv)) == 0) {
+    return obj->read_options;
+  }
+  ro = php_rocksdb_options_cache_find(&obj->read_options_cache,
+    php_rocksdb_readoptions_dtor, options_zv, &key);
+  if (!ro) {
+    ro = rocksdb_readoptions_create();
+    php_rocksdb_readoptions_apply(ro, &obj->read_options_defaults);
+    php_rocksdb_readoptions_apply(ro, options_zv);
+    zend_hash_add_new_ptr(obj->read_options_cache, key, ro);
+    zend_string_release(key);
+  }
+  return ro;
+}
+
+/* Write options for one call; see php_rocksdb_call_read_options() */
+static rocksdb_writeoptions_t *php_rocksdb_call_write_options(rocksdb_object *obj,
+    zval *options_zv) {
+  rocksdb_writeoptions_t *wo;
+  zend_string *key;
+
+  if (!options_zv || zend_hash_num_elements(Z_ARRVAL_P(options_zv)) == 0) {
+    return obj->write_options;
+  }
+  wo = php_rocksdb_options_cache_find(&obj->write_options_cache,
+    php_rocksdb_writeoptions_dtor, options_zv, &key);
+  if (!wo) {
+    wo = rocksdb_writeoptions_create();
+    php_rocksdb_writeoptions_apply(wo, &obj->write_options_defaults);
+    php_rocksdb_writeoptions_apply(wo, options_zv);
+    zend_hash_add_new_ptr(obj->write_options_cache, key, wo);
+    zend_string_release(key);
+  }
+  return wo;
+}
+
+/* Native value codec behind putValue()/getValue(). An encoded value is a
+   version byte followed by one tagged item. Integers are zigzag varints,
+   lists (keys 0..n-1) store their values only, lists of integers drop the
+   per-item tags, and maps store tagged key/value pairs. */
+#define PHP_ROCKSDB_CODEC_V1        0xC1
+#define PHP_ROCKSDB_CODEC_MAX_DEPTH 256
+
+#define PHP_ROCKSDB_TAG_NULL      0
+#define PHP_ROCKSDB_TAG_FALSE     1
+#define PHP_ROCKSDB_TAG_TRUE      2
+#define PHP_ROCKSDB_TAG_INT       3
+#define PHP_ROCKSDB_TAG_DOUBLE    4
+#define PHP_ROCKSDB_TAG_STRING    5
+#define PHP_ROCKSDB_TAG_LIST      6
+#define PHP_ROCKSDB_TAG_INT_LIST  7
+#define PHP_ROCKSDB_TAG_MAP       8
+
+static void php_rocksdb_codec_put_varint(smart_str *buf, uint64_t v) {
+  char tmp[10];
+  size_t n = 0;
+
+  while (v >= 0x80) {
+    tmp[n++] = (char)(v | 0x80);
+    v >>= 7;
+  }
+  tmp[n++] = (char)v;
+  smart_str_appendl(buf, tmp, n);
+}
+
+static inline uint64_t php_rocksdb_codec_zigzag(zend_long v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> (sizeof(zend_long) * 8 - 1));
+}
+
+static inline zend_long php_rocksdb_codec_unzigzag(uint64_t v) {
+  return (zend_long)((v >> 1) ^ (~(v & 1) + 1));
+}
+
+static void php_rocksdb_codec_put_string(smart_str *buf, const char *s, size_t len) {
+  smart_str_appendc(buf, PHP_ROCKSDB_TAG_STRING);
+  php_rocksdb_codec_put_varint(buf, len);
+  smart_str_appendl(buf, s, len);
+}
+
+static int php_rocksdb_codec_encode_zval(smart_str *buf, zval *zv, int depth) {
+  HashTable *ht;
+  zend_ulong idx, expect = 0;
+  zend_string *key;
+  zval *item;
+  zend_bool is_list = 1, all_long = 1;
+  union { double d; uint64_t u; } bits;
+  char raw[8];
+  int i;
+
+  ZVAL_DEREF(zv);
+  switch (Z_TYPE_P(zv)) {
+    case IS_NULL:
+      smart_str_appendc(buf, PHP_ROCKSDB_TAG_NULL);
+      return SUCCESS;
+    case IS_FALSE:
+      smart_str_appendc(buf, PHP_ROCKSDB_TAG_FALSE);
+      return SUCCESS;
+    case IS_TRUE:
+      smart_str_appendc(buf, PHP_ROCKSDB_TAG_TRUE);
+      return SUCCESS;
+    case IS_LONG:
+      smart_str_appendc(buf, PHP_ROCKSDB_TAG_INT);
+      php_rocksdb_codec_put_varint(buf, php_rocksdb_codec_zigzag(Z_LVAL_P(zv)));
+      return SUCCESS;
+    case IS_DOUBLE:
+      /* Little-endian IEEE 754 regardless of the host */
+      bits.d = Z_DVAL_P(zv);
+      for (i = 0; i < 8; i++) {
+        raw[i] = (char)(bits.u >> (i * 8));
+      }
+      smart_str_appendc(buf, PHP_ROCKSDB_TAG_DOUBLE);
+      smart_str_appendl(buf, raw, sizeof(raw));
+      return SUCCESS;
+    case IS_STRING:
+      php_rocksdb_codec_put_string(buf, Z_STRVAL_P(zv), Z_STRLEN_P(zv));
+      return SUCCESS;
+    case IS_ARRAY:
+      break;
+    default:
+      zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+        "Cannot encode a value of type %s", zend_zval_type_name(zv));
+      return FAILURE;
+  }
+
+  if (depth >= PHP_ROCKSDB_CODEC_MAX_DEPTH) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Cannot encode arrays nested deeper than %d levels", PHP_ROCKSDB_CODEC_MAX_DEPTH);
+    return FAILURE;
+  }
+  ht = Z_ARRVAL_P(zv);
+  ZEND_HASH_FOREACH_KEY_VAL(ht, idx, key, item) {
+    if (key || idx != expect++) {
+      is_list = 0;
+      break;
+    }
+    ZVAL_DEREF(item);
+    all_long = all_long && Z_TYPE_P(item) == IS_LONG;
+  } ZEND_HASH_FOREACH_END();
+
+  if (is_list && all_long && zend_hash_num_elements(ht) > 0) {
+    smart_str_appendc(buf, PHP_ROCKSDB_TAG_INT_LIST);
+    php_rocksdb_codec_put_varint(buf, zend_hash_num_elements(ht));
+    ZEND_HASH_FOREACH_VAL(ht, item) {
+      ZVAL_DEREF(item);
+      php_rocksdb_codec_put_varint(buf, php_rocksdb_codec_zigzag(Z_LVAL_P(item)));
+    } ZEND_HASH_FOREACH_END();
+    return SUCCESS;
+  }
+
+  smart_str_appendc(buf, is_list ? PHP_ROCKSDB_TAG_LIST : PHP_ROCKSDB_TAG_MAP);
+  php_rocksdb_codec_put_varint(buf, zend_hash_num_elements(ht));
+  ZEND_HASH_FOREACH_KEY_VAL(ht, idx, key, item) {
+    if (!is_list) {
+      if (key) {
+        php_rocksdb_codec_put_string(buf, ZSTR_VAL(key), ZSTR_LEN(key));
+      } else {
+        smart_str_appendc(buf, PHP_ROCKSDB_TAG_INT);
+        php_rocksdb_codec_put_varint(buf, php_rocksdb_codec_zigzag((zend_long)idx));
+      }
+    }
+    if (php_rocksdb_codec_encode_zval(buf, item, depth + 1) == FAILURE) {
+      return FAILURE;
+    }
+  } ZEND_HASH_FOREACH_END();
+  return SUCCESS;
+}
+
+/* Encodes 'zv' into 'buf' (not yet terminated); throws on unsupported types */
+static int php_rocksdb_codec_encode(smart_str *buf, zval *zv) {
+  smart_str_appendc(buf, (char)PHP_ROCKSDB_CODEC_V1);
+  if (php_rocksdb_codec_encode_zval(buf, zv, 0) == FAILURE) {
+    smart_str_free(buf);
+    return FAILURE;
+  }
+  return SUCCESS;
+}
+
+typedef struct _php_rocksdb_codec_reader {
+  const unsigned char *p;
+  const unsigned char *end;
+} php_rocksdb_codec_reader;
+
+static int php_rocksdb_codec_get_varint(php_rocksdb_codec_reader *r, uint64_t *out) {
+  uint64_t v = 0;
+  int shift;
+
+  for (shift = 0; shift < 64 && r->p < r->end; shift += 7) {
+    unsigned char b = *r->p++;
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      *out = v;
+      return SUCCESS;
+    }
+  }
+  return FAILURE;
+}
+
+/* Element counts are checked against the remaining input (every item takes
+   at least one byte) so corrupt data cannot trigger huge allocations. */
+static int php_rocksdb_codec_get_count(php_rocksdb_codec_reader *r, uint32_t *out) {
+  uint64_t n;
+
+  if (php_rocksdb_codec_get_varint(r, &n) == FAILURE
+      || n > (uint64_t)(r->end - r->p) || n > HT_MAX_SIZE) {
+    return FAILURE;
+  }
+  *out = (uint32_t)n;
+  return SUCCESS;
+}
+
+static int php_rocksdb_codec_get_bytes(php_rocksdb_codec_reader *r,
+    const char **s, size_t *len) {
+  uint64_t n;
+
+  if (php_rocksdb_codec_get_varint(r, &n) == FAILURE || n > (uint64_t)(r->end - r->p)) {
+    return FAILURE;
+  }
+  *s = (const char *)r->p;
+  *len = (size_t)n;
+  r->p += n;
+  return SUCCESS;
+}
+
+/* On failure 'out' is left undefined with nothing to release */
+static int php_rocksdb_codec_decode_zval(php_rocksdb_codec_reader *r, zval *out, int depth) {
+  uint64_t u;
+  uint32_t n, i;
+  const char *s;
+  size_t len;
+  unsigned char tag;
+  int b;
+
+  ZVAL_UNDEF(out);
+  if (r->p >= r->end) {
+    return FAILURE;
+  }
+  tag = *r->p++;
+  switch (tag) {
+    case PHP_ROCKSDB_TAG_NULL:
+      ZVAL_NULL(out);
+      return SUCCESS;
+    case PHP_ROCKSDB_TAG_FALSE:
+      ZVAL_FALSE(out);
+      return SUCCESS;
+    case PHP_ROCKSDB_TAG_TRUE:
+      ZVAL_TRUE(out);
+      return SUCCESS;
+    case PHP_ROCKSDB_TAG_INT:
+      if (php_rocksdb_codec_get_varint(r, &u) == FAILURE) {
+        return FAILURE;
+      }
+      ZVAL_LONG(out, php_rocksdb_codec_unzigzag(u));
+      return SUCCESS;
+    case PHP_ROCKSDB_TAG_DOUBLE: {
+      union { double d; uint64_t u; } bits;
+      if (r->end - r->p < 8) {
+        return FAILURE;
+      }
+      bits.u = 0;
+      for (b = 0; b < 8; b++) {
+        bits.u |= (uint64_t)r->p[b] << (b * 8);
+      }
+      r->p += 8;
+      ZVAL_DOUBLE(out, bits.d);
+      return SUCCESS;
+    }
+    case PHP_ROCKSDB_TAG_STRING:
+      if (php_rocksdb_codec_get_bytes(r, &s, &len) == FAILURE) {
+        return FAILURE;
+      }
+      ZVAL_STRINGL(out, s, len);
+      return SUCCESS;
+    case PHP_ROCKSDB_TAG_LIST:
+    case PHP_ROCKSDB_TAG_INT_LIST:
+    case PHP_ROCKSDB_TAG_MAP:
+      break;
+    default:
+      return FAILURE;
+  }
+
+  if (depth >= PHP_ROCKSDB_CODEC_MAX_DEPTH
+      || php_rocksdb_codec_get_count(r, &n) == FAILURE) {
+    return FAILURE;
+  }
+  array_init_size(out, n);
+  if (tag != PHP_ROCKSDB_TAG_MAP) {
+    zend_hash_real_init_packed(Z_ARRVAL_P(out));
+  }
+  for (i = 0; i < n; i++) {
+    zval item;
+
+    if (tag == PHP_ROCKSDB_TAG_INT_LIST) {
+      if (php_rocksdb_codec_get_varint(r, &u) == FAILURE) {
+        goto fail;
+      }
+      ZVAL_LONG(&item, php_rocksdb_codec_unzigzag(u));
+      zend_hash_next_index_insert_new(Z_ARRVAL_P(out), &item);
+    } else if (tag == PHP_ROCKSDB_TAG_LIST) {
+      if (php_rocksdb_codec_decode_zval(r, &item, depth + 1) == FAILURE) {
+        goto fail;
+      }
+      zend_hash_next_index_insert_new(Z_ARRVAL_P(out), &item);
+    } else {
+      /* Map key: a tagged string or integer */
+      if (r->p >= r->end) {
+        goto fail;
+      }
+      tag = *r->p++;
+      if (tag == PHP_ROCKSDB_TAG_STRING) {
+        if (php_rocksdb_codec_get_bytes(r, &s, &len) == FAILURE
+            || php_rocksdb_codec_decode_zval(r, &item, depth + 1) == FAILURE) {
+          goto fail;
+        }
+        zend_symtable_str_update(Z_ARRVAL_P(out), s, len, &item);
+      } else if (tag == PHP_ROCKSDB_TAG_INT) {
+        if (php_rocksdb_codec_get_varint(r, &u) == FAILURE
+            || php_rocksdb_codec_decode_zval(r, &item, depth + 1) == FAILURE) {
+          goto fail;
+        }
+        zend_hash_index_update(Z_ARRVAL_P(out), (zend_ulong)php_rocksdb_codec_unzigzag(u), &item);
+      } else {
+        goto fail;
+      }
+      tag = PHP_ROCKSDB_TAG_MAP;
+    }
+  }
+  return SUCCESS;
+
+fail:
+  zval_ptr_dtor(out);
+  ZVAL_UNDEF(out);
+  return FAILURE;
+}
+
+/* Decodes a putValue() value into 'out'; throws and returns FAILURE when
+   the bytes were not written by the codec or are damaged. */
+static int php_rocksdb_codec_decode(const char *val, size_t val_len, zval *out) {
+  php_rocksdb_codec_reader r;
+
+  r.p = (const unsigned char *)val;
+  r.end = r.p + val_len;
+  if (val_len < 2 || *r.p++ != PHP_ROCKSDB_CODEC_V1
+      || php_rocksdb_codec_decode_zval(&r, out, 0) == FAILURE) {
+    ZVAL_UNDEF(out);
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Value is not in the RocksDB value format", 0);
+    return FAILURE;
+  }
+  if (r.p != r.end) {
+    zval_ptr_dtor(out);
+    ZVAL_UNDEF(out);
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Value is not in the RocksDB value format", 0);
+    return FAILURE;
+  }
+  return SUCCESS;
+}
+
+/* Validates a put() $ttlSeconds; throws and returns 0 when unusable */
+static zend_bool php_rocksdb_check_ttl(rocksdb_object *obj, zend_long ttl) {
+  if (ttl <= 0) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "TTL must be a positive number of seconds", 0);
+    return 0;
+  }
+  if (!obj->expiry_filter) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Writing with a TTL needs the 'expiry_filter' option", 0);
+    return 0;
+  }
+  return 1;
+}
+
+/* Single put, routed through the transaction DB when there is one. Under
+   'expiry_filter' the value gets the expiry header, 'ttl' 0 for never. */
+static void php_rocksdb_put(rocksdb_object *obj, rocksdb_writeoptions_t *wo,
+    rocksdb_column_family_object *cf_obj, const char *key, size_t key_len,
+    const char *value, size_t value_len, zend_long ttl, char **err) {
+  char *framed = NULL;
+
+  if (obj->expiry_filter) {
+    framed = php_rocksdb_expiry_frame(value, value_len, ttl, &value_len);
+    value = framed;
+  }
+  if (obj->txn_db) {
+    if (cf_obj) {
+      rocksdb_transactiondb_put_cf(obj->txn_db, wo, cf_obj->cf->handle,
+        key, key_len, value, value_len, err);
+    } else {
+      rocksdb_transactiondb_put(obj->txn_db, wo, key, key_len, value, value_len, err);
+    }
+  } else if (cf_obj) {
+    rocksdb_put_cf(obj->db, wo, cf_obj->cf->handle,
+      key, key_len, value, value_len, err);
+  } else {
+    rocksdb_put(obj->db, wo, key, key_len, value, value_len, err);
+  }
+  if (framed) {
+    efree(framed);
+  }
+}
+
+/* Value of a pinned lookup without its expiry header. Returns 0 when the
+   key is missing or its value has expired (the slice is then released). */
+static zend_bool php_rocksdb_pinned_value(rocksdb_object *obj,
+    rocksdb_pinnableslice_t **slice, const char **val, size_t *len) {
+  if (!*slice) {
+    return 0;
+  }
+  *val = rocksdb_pinnableslice_value(*slice, len);
+  if (obj->expiry_filter && php_rocksdb_expiry_strip(val, len)) {
+    rocksdb_pinnableslice_destroy(*slice);
+    *slice = NULL;
+    return 0;
+  }
+  return 1;
+}
+
+/* Copies the iterator's current value into 'out', decoded when asked */
+static int php_rocksdb_iterator_value(rocksdb_iterator_object *it_obj, zval *out, zend_bool decode) {
+  size_t val_len;
+  const char *val = rocksdb_iter_value(it_obj->iter, &val_len);
+
+  if (it_obj->db_obj->expiry_filter) {
+    php_rocksdb_expiry_strip(&val, &val_len);
+  }
+
+  if (decode) {
+    return php_rocksdb_codec_decode(val, val_len, out);
+  }
+  ZVAL_STRINGL(out, val, val_len);
+  return SUCCESS;
+}
+
+/* Point lookup returning the value pinned in the block cache or memtable
+   (NULL when missing), so callers copy it at most once. */
+static rocksdb_pinnableslice_t *php_rocksdb_get_pinned(rocksdb_object *obj,
+    rocksdb_readoptions_t *ro, rocksdb_snapshot_object *snap_obj,
+    rocksdb_column_family_object *cf_obj, const char *key, size_t key_len, char **err) {
+  rocksdb_pinnableslice_t *slice;
+
+  if (snap_obj) {
+    rocksdb_readoptions_set_snapshot(ro, snap_obj->snapshot);
+  }
+  slice = cf_obj
+    ? rocksdb_get_pinned_cf(obj->db, ro, cf_obj->cf->handle, key, key_len, err)
+    : rocksdb_get_pinned(obj->db, ro, key, key_len, err);
+  if (snap_obj) {
+    rocksdb_readoptions_set_snapshot(ro, NULL);
+  }
+  return slice;
+}
+
+/* ---------------------- foreach Support ---------------------- */
+
+/* foreach over a RocksDBIterator drives rocksdb_iter_* directly instead of
+   dispatching to the userland-visible Iterator methods on every row. */
+typedef struct _php_rocksdb_zend_iterator {
+  zend_object_iterator intern;
+  zval current;
+} php_rocksdb_zend_iterator;
+
+static inline rocksdb_iterator_object *
+php_rocksdb_zend_iterator_object(zend_object_iterator *iter) {
+  return php_rocksdb_iterator_object_from_zobj(Z_OBJ(iter->data));
+}
+
+static void php_rocksdb_zend_iterator_dtor(zend_object_iterator *iter) {
+  php_rocksdb_zend_iterator *it = (php_rocksdb_zend_iterator *)iter;
+  zval_ptr_dtor(&it->current);
+  zval_ptr_dtor(&iter->data);
+}
+
+static int php_rocksdb_zend_iterator_valid(zend_object_iterator *iter) {
+  rocksdb_iterator_object *it_obj = php_rocksdb_zend_iterator_object(iter);
+  return php_rocksdb_iterator_usable(it_obj) && php_rocksdb_iterator_in_range(it_obj)
+    ? SUCCESS : FAILURE;
+}
+
+static zval *php_rocksdb_zend_iterator_get_current_data(zend_object_iterator *iter) {
+  php_rocksdb_zend_iterator *it = (php_rocksdb_zend_iterator *)iter;
+  rocksdb_iterator_object *it_obj = php_rocksdb_zend_iterator_object(iter);
+
+  zval_ptr_dtor(&it->current);
+  if (php_rocksdb_iterator_value(it_obj, &it->current, it_obj->decode_values) == FAILURE) {
+    ZVAL_NULL(&it->current);
+  }
+  return &it->current;
+}
+
+static void php_rocksdb_zend_iterator_get_current_key(zend_object_iterator *iter, zval *key) {
+  rocksdb_iterator_object *it_obj = php_rocksdb_zend_iterator_object(iter);
+  size_t key_len;
+  const char *k = rocksdb_iter_key(it_obj->iter, &key_len);
+  ZVAL_STRINGL(key, k, key_len);
+}
+
+static void php_rocksdb_zend_iterator_move_forward(zend_object_iterator *iter) {
+  rocksdb_iterator_object *it_obj = php_rocksdb_zend_iterator_object(iter);
+  if (it_obj->iter && rocksdb_iter_valid(it_obj->iter)) {
+    it_obj->backward = 0;
+    rocksdb_iter_next(it_obj->iter);
+  }
+}
+
+static void php_rocksdb_zend_iterator_rewind(zend_object_iterator *iter) {
+  php_rocksdb_iterator_rewind(php_rocksdb_zend_iterator_object(iter));
+}
+
+static const zend_object_iterator_funcs php_rocksdb_zend_iterator_funcs = {
+  php_rocksdb_zend_iterator_dtor,
+  php_rocksdb_zend_iterator_valid,
+  php_rocksdb_zend_iterator_get_current_data,
+  php_rocksdb_zend_iterator_get_current_key,
+  php_rocksdb_zend_iterator_move_forward,
+  php_rocksdb_zend_iterator_rewind,
+  NULL,                                /* invalidate_current */
+#if PHP_VERSION_ID >= 80000
+  NULL,                                /* get_gc */
+#endif
+};
+
+static zend_object_iterator *php_rocksdb_iterator_get_iterator(zend_class_entry *ce,
+    zval *object, int by_ref) {
+  php_rocksdb_zend_iterator *it;
+
+  if (by_ref) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "RocksDBIterator cannot be iterated by reference", 0);
+    return NULL;
+  }
+
+  it = ecalloc(1, sizeof(php_rocksdb_zend_iterator));
+  zend_iterator_init(&it->intern);
+  ZVAL_OBJ_COPY(&it->intern.data, Z_OBJ_P(object));
+  it->intern.funcs = &php_rocksdb_zend_iterator_funcs;
+  ZVAL_UNDEF(&it->current);
+  return &it->intern;
+}
+
+/* ---------------------- Arginfo Declarations ---------------------- */
+
+/* RocksDB::tryCatchUpWithPrimary(?int $minInterval = null): bool */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_tryCatchUpWithPrimary, 0, 0, _IS_BOOL, 0)
+  ZEND_ARG_TYPE_INFO(0, minInterval, IS_LONG, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::compactRange(?string $begin = null, ?string $end = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_compactRange, 0, 0, 0)
+  ZEND_ARG_TYPE_INFO(0, begin, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, end,   IS_STRING, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::__construct(string $path, array $options = null) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb___construct, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, path, IS_STRING, 0)
+  ZEND_ARG_ARRAY_INFO(0, options, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::get(string $key, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): string|false */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_get, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getInto(string $key, mixed &$value, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getInto, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_INFO(1, value)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getRange(string $key, int $offset, ?int $length = null, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): ?string */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getRange, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, offset, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, length, IS_LONG, 1)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::multiGet(array $keys, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, bool $sortedInput = false, ?array $readOptions = null): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_multiGet, 0, 0, 1)
+  ZEND_ARG_ARRAY_INFO(0, keys, 0)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_TYPE_INFO(0, sortedInput, _IS_BOOL, 0)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::put(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null, ?int $ttlSeconds = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_put, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+  ZEND_ARG_TYPE_INFO(0, ttlSeconds, IS_LONG, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::putValue(string $key, mixed $value, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null, ?int $ttlSeconds = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_putValue, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_INFO(0, value)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+  ZEND_ARG_TYPE_INFO(0, ttlSeconds, IS_LONG, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getValue(string $key, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): mixed */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getValue, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::merge(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_merge, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::delete(string $key, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_delete, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::deleteRange(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_deleteRange, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::deletePrefix(string $prefix, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_deletePrefix, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::deleteFilesInRange(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_deleteFilesInRange, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::write(RocksDBWriteBatch $batch, ?array $writeOptions = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_write, 0, 0, 1)
+  ZEND_ARG_OBJ_INFO(0, batch, RocksDBWriteBatch, 0)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getIterator(?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator (IteratorAggregate) */
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_rocksdb_getIterator, 0, 0, Traversable, 0)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getProperty(string $name): string|null */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getProperty, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::prefixSearch(string $prefix, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_prefixSearch, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getColumnFamily(string $name): RocksDBColumnFamily */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getColumnFamily, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::createColumnFamily(string $name, ?array $options = null): RocksDBColumnFamily */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_createColumnFamily, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+  ZEND_ARG_ARRAY_INFO(0, options, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::dropColumnFamily(RocksDBColumnFamily $columnFamily): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_dropColumnFamily, 0, 0, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::listColumnFamilies(): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_listColumnFamilies, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::ingestExternalFiles(array $paths, ?array $options = null, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_ingestExternalFiles, 0, 0, 1)
+  ZEND_ARG_ARRAY_INFO(0, paths, 0)
+  ZEND_ARG_ARRAY_INFO(0, options, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getSnapshot(): RocksDBSnapshot */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getSnapshot, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getSnapshotStats(): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getSnapshotStats, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getCacheStats(): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getCacheStats, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getIntProperty(string $name, ?RocksDBColumnFamily $columnFamily = null): ?int,
+   getMapProperty(...): ?array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getTypedProperty, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getEstimatedNumKeys(?RocksDBColumnFamily $columnFamily = null): ?int,
+   getEstimatedLiveDataSize(...), getTotalSstFilesSize(...): ?int,
+   getLevelStats(...): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getSizeProperty, 0, 0, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::approximateSizes(array $ranges, bool $includeMemtables = false, ?RocksDBColumnFamily $columnFamily = null): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_approximateSizes, 0, 0, 1)
+  ZEND_ARG_ARRAY_INFO(0, ranges, 0)
+  ZEND_ARG_TYPE_INFO(0, includeMemtables, _IS_BOOL, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::approximateMemtableStats(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_approximateMemtableStats, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::getStatistics(): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getStatistics, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* static RocksDB::setPerfLevel(int $level): void */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_setPerfLevel, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, level, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+/* static RocksDB::resetPerfContext(): void */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_resetPerfContext, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* static RocksDB::getPerfContext(bool $excludeZero = false): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_getPerfContext, 0, 0, 0)
+  ZEND_ARG_TYPE_INFO(0, excludeZero, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* static RocksDB::profile(callable $fn, int $level = RocksDB::PERF_ENABLE_TIME_EXCEPT_FOR_MUTEX, bool $excludeZero = false): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_profile, 0, 0, 1)
+  ZEND_ARG_CALLABLE_INFO(0, fn, 0)
+  ZEND_ARG_TYPE_INFO(0, level, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, excludeZero, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::scan(?string $start = null, ?string $end = null, int $limit = 0, bool $reverse = false, ?array $readOptions = null): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_scan, 0, 0, 0)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, limit, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, reverse, _IS_BOOL, 0)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::parallelScan(?string $start = null, ?string $end = null, int $threads = 0, int $op = RocksDB::SCAN_COUNT, ?RocksDBColumnFamily $columnFamily = null, ?RocksDBSnapshot $snapshot = null): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_parallelScan, 0, 0, 0)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, threads, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, op, IS_LONG, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBatch::__construct() */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch___construct, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBatch::put(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_put, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBatch::merge(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_merge, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBatch::delete(string $key, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_delete, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBatch::deleteRange(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_deleteRange, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBatch::clear(): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_writebatch_clear, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::__construct(RocksDB $db, ?string $prefix = null, ?string $start = null, ?string $end = null, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator___construct, 0, 0, 1)
+  ZEND_ARG_OBJ_INFO(0, db, RocksDB, 0)
+  ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, start, IS_STRING, 1)
+  ZEND_ARG_TYPE_INFO(0, end, IS_STRING, 1)
+  ZEND_ARG_OBJ_INFO(0, snapshot, RocksDBSnapshot, 1)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::valid(): bool */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_valid, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::key(): string|false */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_key, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::current(): string|false */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_current, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::next(): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_next, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::rewind(): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_rewind, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::prev(): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_prev, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::seek(string $key): void, seekForPrev(string $key): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_seek, 0, 1, IS_VOID, 0)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::seekToFirst(): void, seekToLast(): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_seekTo, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::fetch(int $n, int $mode = RocksDBIterator::KEYS_AND_VALUES): array */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_fetch, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, n, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, mode, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::destroy(): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_iterator_destroy, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBIterator::decodeValues(bool $decode = true): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_rocksdb_iterator_decodeValues, 0, 0, IS_VOID, 0)
+  ZEND_ARG_TYPE_INFO(0, decode, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBCache::__construct(int $capacity, bool $strictCapacityLimit = false) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_cache___construct, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, capacity, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, strictCapacityLimit, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBCache::setCapacity(int $capacity): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_cache_setCapacity, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, capacity, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBCache::getCapacity(): int, getUsage(): int, getPinnedUsage(): int */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_cache_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBufferManager::__construct(int $bufferSize, ?RocksDBCache $cache = null, bool $allowStall = false) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_write_buffer_manager___construct, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, bufferSize, IS_LONG, 0)
+  ZEND_ARG_OBJ_INFO(0, cache, RocksDBCache, 1)
+  ZEND_ARG_TYPE_INFO(0, allowStall, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBufferManager::setBufferSize(int $bufferSize): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_write_buffer_manager_setBufferSize, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, bufferSize, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBufferManager::setAllowStall(bool $allowStall): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_write_buffer_manager_setAllowStall, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, allowStall, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBWriteBufferManager::getBufferSize(): int, getMemoryUsage(): int,
+   getMutableMemoryUsage(): int, getCacheUsage(): int */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_write_buffer_manager_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBRateLimiter::__construct(int $bytesPerSecond, bool $autoTuned = false, int $refillPeriodMicros = 100000, int $fairness = 10) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_rate_limiter___construct, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, bytesPerSecond, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, autoTuned, _IS_BOOL, 0)
+  ZEND_ARG_TYPE_INFO(0, refillPeriodMicros, IS_LONG, 0)
+  ZEND_ARG_TYPE_INFO(0, fairness, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSnapshot::__construct(RocksDB $db) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_snapshot___construct, 0, 0, 1)
+  ZEND_ARG_OBJ_INFO(0, db, RocksDB, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSnapshot::getSequenceNumber(): int, release(): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_snapshot_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSstFileWriter::__construct(?array $options = null) */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_sst_file_writer___construct, 0, 0, 0)
+  ZEND_ARG_ARRAY_INFO(0, options, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSstFileWriter::open(string $path): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_sst_file_writer_open, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, path, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSstFileWriter::put(string $key, string $value): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_sst_file_writer_put, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSstFileWriter::delete(string $key): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_sst_file_writer_delete, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBSstFileWriter::finish(): bool, getFileSize(): int */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_sst_file_writer_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDB::beginTransaction(?array $options = null, ?array $writeOptions = null): RocksDBTransaction */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_beginTransaction, 0, 0, 0)
+  ZEND_ARG_ARRAY_INFO(0, options, 1)
+  ZEND_ARG_ARRAY_INFO(0, writeOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::get(string $key, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): ?string */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_get, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::getForUpdate(string $key, ?RocksDBColumnFamily $columnFamily = null, bool $exclusive = true, ?array $readOptions = null): ?string */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_getForUpdate, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_TYPE_INFO(0, exclusive, _IS_BOOL, 0)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::put(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool,
+   merge(...): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_put, 0, 0, 2)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::delete(string $key, ?RocksDBColumnFamily $columnFamily = null): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_delete, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::getIterator(?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_getIterator, 0, 0, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::prefixSearch(string $prefix, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_prefixSearch, 0, 0, 1)
+  ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 0)
+  ZEND_ARG_OBJ_INFO(0, columnFamily, RocksDBColumnFamily, 1)
+  ZEND_ARG_ARRAY_INFO(0, readOptions, 1)
+ZEND_END_ARG_INFO()
+
+/* RocksDBTransaction::commit(): bool, rollback(): bool, setSavePoint(): bool,
+   rollbackToSavePoint(): bool */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_transaction_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* RocksDBColumnFamily::getName(): string */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rocksdb_column_family_getName, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+/* ---------------------- Method Implementations ---------------------- */
+
+/* --- RocksDB::__construct(...) with advanced options --- */
+PHP_METHOD(RocksDB, __construct)
+{
+  char *path;
+  size_t path_len;
+  zval *options_zv = NULL;
+  rocksdb_object *obj;
+  int mode = PHP_ROCKSDB_OPEN_READ_WRITE;
+  zend_bool persistent = 0;
+  zend_string *persistent_key = NULL;
+  HashTable *ht = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|a",
+      &path, &path_len, &options_zv) == FAILURE) {
+    return;
+  }
+
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  obj->options = rocksdb_options_create();
+  rocksdb_options_set_create_if_missing(obj->options, 1);
+
+  if (options_zv && Z_TYPE_P(options_zv) == IS_ARRAY) {
+    zval *val;
+    zend_bool failed = 0;
+
+    ht = Z_ARRVAL_P(options_zv);
+
+    obj->block_cache = php_rocksdb_cache_from_options(ht,
+      "block_cache", sizeof("block_cache") - 1,
+      "block_cache_size", sizeof("block_cache_size") - 1, &failed);
+    if (!failed) {
+      obj->row_cache = php_rocksdb_cache_from_options(ht,
+        "row_cache", sizeof("row_cache") - 1,
+        "row_cache_size", sizeof("row_cache_size") - 1, &failed);
+    }
+    if (failed) {
+      return;
+    }
+    if (obj->row_cache) {
+      rocksdb_options_set_row_cache(obj->options, obj->row_cache->cache);
+    }
+
+    if ((val = zend_hash_str_find(ht, "read_only", sizeof("read_only") - 1)) != NULL) {
+      if (zend_is_true(val)) {
+        mode = PHP_ROCKSDB_OPEN_READ_ONLY;
+        rocksdb_options_set_create_if_missing(obj->options, 0);
+      }
+    }
+    if ((val = zend_hash_str_find(ht, "secondary_path", sizeof("secondary_path") - 1)) != NULL
+        && Z_TYPE_P(val) != IS_NULL) {
+      if (Z_TYPE_P(val) != IS_STRING || Z_STRLEN_P(val) == 0) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'secondary_path' must be a non-empty string", 0);
+        return;
+      }
+      if (mode == PHP_ROCKSDB_OPEN_READ_ONLY) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'secondary_path' cannot be combined with 'read_only'", 0);
+        return;
+      }
+      mode = PHP_ROCKSDB_OPEN_SECONDARY;
+      /* Secondaries must keep every table file open to follow the primary;
+         an explicit max_open_files below still wins */
+      rocksdb_options_set_max_open_files(obj->options, -1);
+      if ((val = zend_hash_str_find(ht, "catch_up_interval", sizeof("catch_up_interval") - 1)) != NULL) {
+        obj->catch_up_interval_ms = zval_get_long(val);
+      }
+    }
+    if ((val = zend_hash_str_find(ht, "transaction_db", sizeof("transaction_db") - 1)) != NULL
+        && Z_TYPE_P(val) != IS_NULL && Z_TYPE_P(val) != IS_FALSE) {
+      zend_string *kind = zval_get_string(val);
+      int txn_mode = -1;
+      if (zend_string_equals_literal(kind, "pessimistic")) {
+        txn_mode = PHP_ROCKSDB_OPEN_PESSIMISTIC;
+      } else if (zend_string_equals_literal(kind, "optimistic")) {
+        txn_mode = PHP_ROCKSDB_OPEN_OPTIMISTIC;
+      }
+      zend_string_release(kind);
+      if (txn_mode < 0) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'transaction_db' must be 'pessimistic' or 'optimistic'", 0);
+        return;
+      }
+      if (mode == PHP_ROCKSDB_OPEN_READ_ONLY || mode == PHP_ROCKSDB_OPEN_SECONDARY) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          mode == PHP_ROCKSDB_OPEN_READ_ONLY
+            ? "Option 'transaction_db' cannot be combined with 'read_only'"
+            : "Option 'transaction_db' cannot be combined with 'secondary_path'", 0);
+        return;
+      }
+      mode = txn_mode;
+    }
+    if ((val = zend_hash_str_find(ht, "ttl", sizeof("ttl") - 1)) != NULL
+        && Z_TYPE_P(val) != IS_NULL) {
+      zend_long ttl = zval_get_long(val);
+      if (ttl <= 0 || ttl > INT_MAX) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'ttl' must be a positive number of seconds", 0);
+        return;
+      }
+      if (mode != PHP_ROCKSDB_OPEN_READ_WRITE) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'ttl' cannot be combined with 'read_only', 'secondary_path' or 'transaction_db'", 0);
+        return;
+      }
+      mode = PHP_ROCKSDB_OPEN_TTL;
+    }
+    if ((val = zend_hash_str_find(ht, "expiry_filter", sizeof("expiry_filter") - 1)) != NULL) {
+      obj->expiry_filter = zend_is_true(val);
+    }
+    if ((val = zend_hash_str_find(ht, "persistent", sizeof("persistent") - 1)) != NULL) {
+      persistent = zend_is_true(val);
+    }
+
+    if ((val = zend_hash_str_find(ht, "create_if_missing", sizeof("create_if_missing") - 1)) != NULL) {
+      rocksdb_options_set_create_if_missing(obj->options, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(ht, "allow_ingest_behind", sizeof("allow_ingest_behind") - 1)) != NULL) {
+      rocksdb_options_set_allow_ingest_behind(obj->options, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(ht, "write_buffer_manager", sizeof("write_buffer_manager") - 1)) != NULL) {
+      rocksdb_write_buffer_manager_object *wbm_obj = NULL;
+      if (Z_TYPE_P(val) == IS_OBJECT &&
+          instanceof_function(Z_OBJCE_P(val), php_rocksdb_write_buffer_manager_ce)) {
+        wbm_obj = php_rocksdb_write_buffer_manager_object_from_zobj(Z_OBJ_P(val));
+      }
+      if (!wbm_obj || !wbm_obj->wbm) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'write_buffer_manager' must be an initialized RocksDBWriteBufferManager", 0);
+        return;
+      }
+      obj->write_buffer_manager = wbm_obj->wbm;
+      obj->write_buffer_manager->refcount++;
+      rocksdb_options_set_write_buffer_manager(obj->options, wbm_obj->wbm->wbm);
+    }
+    if ((val = zend_hash_str_find(ht, "rate_limiter", sizeof("rate_limiter") - 1)) != NULL) {
+      rocksdb_rate_limiter_object *rl_obj = NULL;
+      if (Z_TYPE_P(val) == IS_OBJECT &&
+          instanceof_function(Z_OBJCE_P(val), php_rocksdb_rate_limiter_ce)) {
+        rl_obj = php_rocksdb_rate_limiter_object_from_zobj(Z_OBJ_P(val));
+      }
+      if (!rl_obj || !rl_obj->limiter) {
+        zend_throw_exception(php_rocksdb_exception_ce,
+          "Option 'rate_limiter' must be an initialized RocksDBRateLimiter", 0);
+        return;
+      }
+      obj->rate_limiter = rl_obj->limiter;
+      obj->rate_limiter->refcount++;
+      rocksdb_options_set_ratelimiter(obj->options, rl_obj->limiter->limiter);
+    }
+    if ((val = zend_hash_str_find(ht, "enable_statistics", sizeof("enable_statistics") - 1)) != NULL) {
+      /* true keeps RocksDB's default level; an int picks a STATS_* level */
+      if (Z_TYPE_P(val) == IS_LONG) {
+        rocksdb_options_enable_statistics(obj->options);
+        rocksdb_options_set_statistics_level(obj->options, (int)Z_LVAL_P(val));
+      } else if (zend_is_true(val)) {
+        rocksdb_options_enable_statistics(obj->options);
+      }
+    }
+    if ((val = zend_hash_str_find(ht, "read_options", sizeof("read_options") - 1)) != NULL
+        && Z_TYPE_P(val) == IS_ARRAY) {
+      ZVAL_COPY(&obj->read_options_defaults, val);
+    }
+    if ((val = zend_hash_str_find(ht, "write_options", sizeof("write_options") - 1)) != NULL
+        && Z_TYPE_P(val) == IS_ARRAY) {
+      ZVAL_COPY(&obj->write_options_defaults, val);
+    }
+  }
+
+  if (!php_rocksdb_options_apply(obj->options, ht, obj->block_cache,
+      &obj->prefix_extractor, &obj->prefix_extractor_len)) {
+    return;
+  }
+
+  obj->read_options = rocksdb_readoptions_create();
+  php_rocksdb_readoptions_apply(obj->read_options, &obj->read_options_defaults);
+  obj->write_options = rocksdb_writeoptions_create();
+  php_rocksdb_writeoptions_apply(obj->write_options, &obj->write_options_defaults);
+
+  if (persistent) {
+    php_rocksdb_persistent *pdb;
+    smart_str key = {0};
+
+    smart_str_appends(&key, mode == PHP_ROCKSDB_OPEN_READ_ONLY ? "ro:"
+      : mode == PHP_ROCKSDB_OPEN_SECONDARY ? "sec:" : "rw:");
+    smart_str_appendl(&key, path, path_len);
+    smart_str_appendc(&key, ':');
+    php_rocksdb_options_signature(&key, Z_ARRVAL_P(options_zv));
+    smart_str_0(&key);
+
+    pdb = zend_hash_find_ptr(&ROCKSDB_G(persistent_dbs), key.s);
+    if (pdb) {
+      smart_str_free(&key);
+      rocksdb_options_destroy(obj->options);
+      php_rocksdb_cache_release(obj->block_cache);
+      php_rocksdb_cache_release(obj->row_cache);
+      php_rocksdb_write_buffer_manager_release(obj->write_buffer_manager);
+      php_rocksdb_rate_limiter_release(obj->rate_limiter);
+      obj->persistent = pdb;
+      obj->db = pdb->db;
+      obj->txn_db = pdb->txn_db;
+      obj->otxn_db = pdb->otxn_db;
+      obj->options = pdb->options;
+      obj->block_cache = pdb->block_cache;
+      obj->row_cache = pdb->row_cache;
+      obj->write_buffer_manager = pdb->write_buffer_manager;
+      obj->rate_limiter = pdb->rate_limiter;
+      obj->column_families = pdb->column_families;
+      return;
+    }
+    /* The registry outlives the request, so it must own a persistent copy */
+    persistent_key = zend_string_init(ZSTR_VAL(key.s), ZSTR_LEN(key.s), 1);
+    smart_str_free(&key);
+  }
+
+  if (!php_rocksdb_open(obj, path, ht, mode)) {
+    if (persistent_key) {
+      zend_string_release(persistent_key);
+    }
+    return;
+  }
+
+  if (persistent_key) {
+    php_rocksdb_persistent *pdb = pemalloc(sizeof(php_rocksdb_persistent), 1);
+    pdb->db = obj->db;
+    pdb->txn_db = obj->txn_db;
+    pdb->otxn_db = obj->otxn_db;
+    pdb->options = obj->options;
+    pdb->block_cache = obj->block_cache;
+    pdb->row_cache = obj->row_cache;
+    pdb->write_buffer_manager = obj->write_buffer_manager;
+    pdb->rate_limiter = obj->rate_limiter;
+    pdb->column_families = obj->column_families;
+    pdb->last_catch_up_ms = 0;
+    zend_hash_update_ptr(&ROCKSDB_G(persistent_dbs), persistent_key, pdb);
+    zend_string_release(persistent_key);
+    obj->persistent = pdb;
+  }
+}
+
+static uint64_t php_rocksdb_monotonic_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* public function RocksDB::tryCatchUpWithPrimary(?int $minInterval = null): bool
+   Secondary instances only: replays the primary's new MANIFEST and WAL
+   entries so reads see its latest writes. Skipped (returns false) when the
+   last catch-up on this handle is less than $minInterval ms old; defaults
+   to the 'catch_up_interval' option. Persistent handles share the throttle
+   across requests. */
+PHP_METHOD(RocksDB, tryCatchUpWithPrimary)
+{
+  zend_long min_interval = 0;
+  zend_bool min_interval_null = 1;
+  rocksdb_object *obj;
+  uint64_t now, *last;
+  char *err = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l!", &min_interval, &min_interval_null) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (min_interval_null) {
+    min_interval = obj->catch_up_interval_ms;
+  }
+
+  last = obj->persistent ? &obj->persistent->last_catch_up_ms : &obj->last_catch_up_ms;
+  now = php_rocksdb_monotonic_ms();
+  if (min_interval > 0 && *last && now - *last < (uint64_t)min_interval) {
+    RETURN_FALSE;
+  }
+
+  rocksdb_try_catch_up_with_primary(obj->db, &err);
+  ROCKSDB_CHECK_ERROR(err);
+  *last = now;
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::compactRange(?string $begin = null, ?string $end = null): bool */
+PHP_METHOD(RocksDB, compactRange)
+{
+  char *begin = NULL, *end = NULL;
+  size_t blen = 0, elen = 0;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|s!s!", &begin, &blen, &end, &elen) == FAILURE) {
+    return;
+  }
+  rocksdb_object *obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  /* Correct C API call (no read_options parameter) */
+  rocksdb_compact_range(obj->db, begin, blen, end, elen);
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::get(string $key, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): string|false */
+PHP_METHOD(RocksDB, get)
+{
+  char *key;
+  size_t key_len;
+  char *err = NULL;
+  size_t val_len;
+  rocksdb_object *obj;
+  rocksdb_pinnableslice_t *slice;
+  const char *val;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!O!a!", &key, &key_len,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  slice = php_rocksdb_get_pinned(obj, php_rocksdb_call_read_options(obj, read_options_zv),
+    snap_obj, cf_obj, key, key_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  if (!php_rocksdb_pinned_value(obj, &slice, &val, &val_len)) {
+    RETURN_NULL();
+  }
+  RETVAL_STRINGL(val, val_len);
+  rocksdb_pinnableslice_destroy(slice);
+}
+
+/* public function RocksDB::getValue(string $key, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): mixed
+   Reads a value stored by putValue(), decoding it straight from the pinned
+   slice. Returns null when the key is missing. */
+PHP_METHOD(RocksDB, getValue)
+{
+  char *key;
+  size_t key_len;
+  char *err = NULL;
+  size_t val_len;
+  rocksdb_object *obj;
+  rocksdb_pinnableslice_t *slice;
+  const char *val;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!O!a!", &key, &key_len,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  slice = php_rocksdb_get_pinned(obj, php_rocksdb_call_read_options(obj, read_options_zv),
+    snap_obj, cf_obj, key, key_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  if (!php_rocksdb_pinned_value(obj, &slice, &val, &val_len)) {
+    RETURN_NULL();
+  }
+  php_rocksdb_codec_decode(val, val_len, return_value);
+  rocksdb_pinnableslice_destroy(slice);
+}
+
+/* public function RocksDB::getInto(string $key, mixed &$value, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): bool
+   Stores the value in $value and returns whether the key exists, so an
+   empty value and a missing key need no extra comparison. */
+PHP_METHOD(RocksDB, getInto)
+{
+  char *key;
+  size_t key_len;
+  char *err = NULL;
+  size_t val_len;
+  rocksdb_object *obj;
+  rocksdb_pinnableslice_t *slice;
+  const char *val;
+  zval *value_zv;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "sz|O!O!a!", &key, &key_len, &value_zv,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  slice = php_rocksdb_get_pinned(obj, php_rocksdb_call_read_options(obj, read_options_zv),
+    snap_obj, cf_obj, key, key_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  if (!php_rocksdb_pinned_value(obj, &slice, &val, &val_len)) {
+    ZEND_TRY_ASSIGN_REF_NULL(value_zv);
+    RETURN_FALSE;
+  }
+  ZEND_TRY_ASSIGN_REF_STRINGL(value_zv, val, val_len);
+  rocksdb_pinnableslice_destroy(slice);
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::getRange(string $key, int $offset, ?int $length = null, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): ?string
+   substr() of the stored value, copying only the requested bytes out of
+   the pinned block. */
+PHP_METHOD(RocksDB, getRange)
+{
+  char *key;
+  size_t key_len;
+  zend_long offset, length = 0;
+  zend_bool length_is_null = 1;
+  char *err = NULL;
+  size_t val_len, from, count;
+  rocksdb_object *obj;
+  rocksdb_pinnableslice_t *slice;
+  const char *val;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "sl|l!O!O!a!", &key, &key_len,
+      &offset, &length, &length_is_null,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  slice = php_rocksdb_get_pinned(obj, php_rocksdb_call_read_options(obj, read_options_zv),
+    snap_obj, cf_obj, key, key_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  if (!php_rocksdb_pinned_value(obj, &slice, &val, &val_len)) {
+    RETURN_NULL();
+  }
+
+  /* Same clamping rules as substr() */
+  if (offset < 0) {
+    from = (size_t)-offset > val_len ? 0 : val_len - (size_t)-offset;
+  } else {
+    from = (size_t)offset > val_len ? val_len : (size_t)offset;
+  }
+  count = val_len - from;
+  if (!length_is_null) {
+    if (length < 0) {
+      count = (size_t)-length > count ? 0 : count - (size_t)-length;
+    } else if ((size_t)length < count) {
+      count = (size_t)length;
+    }
+  }
+  RETVAL_STRINGL(val + from, count);
+  rocksdb_pinnableslice_destroy(slice);
+}
+
+/* multiGet() and multiGetValues() */
+static void php_rocksdb_multi_get(INTERNAL_FUNCTION_PARAMETERS, zend_bool decode)
+{
+  zval *keys_zv, *zv;
+  HashTable *ht;
+  size_t n, i = 0;
+  zend_string **keys;
+  const char **c_keys;
+  size_t *c_key_lens;
+  rocksdb_pinnableslice_t **values;
+  char **errs;
+  rocksdb_object *obj;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+  php_rocksdb_column_family *cf;
+  zend_bool sorted_input = 0;
+  rocksdb_readoptions_t *ro;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a|O!O!ba!", &keys_zv,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &sorted_input, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  cf = cf_obj ? cf_obj->cf
+    : zend_hash_str_find_ptr(obj->column_families, "default", sizeof("default") - 1);
+
+  ht = Z_ARRVAL_P(keys_zv);
+  n  = zend_hash_num_elements(ht);
+  if (!n) {
+    RETURN_EMPTY_ARRAY();
+  }
+
+  /* zval_get_string() only adds a ref for string keys; the caller's array
+     is left as it was. */
+  keys       = emalloc(sizeof(zend_string*) * n);
+  c_keys     = emalloc(sizeof(char*) * n);
+  c_key_lens = emalloc(sizeof(size_t) * n);
+  values     = ecalloc(n, sizeof(rocksdb_pinnableslice_t*));
+  errs       = ecalloc(n, sizeof(char*));
+
+  ZEND_HASH_FOREACH_VAL(ht, zv) {
+    keys[i]       = zval_get_string(zv);
+    c_keys[i]     = ZSTR_VAL(keys[i]);
+    c_key_lens[i] = ZSTR_LEN(keys[i]);
+    i++;
+  } ZEND_HASH_FOREACH_END();
+
+  ro = php_rocksdb_call_read_options(obj, read_options_zv);
+  if (snap_obj) {
+    rocksdb_readoptions_set_snapshot(ro, snap_obj->snapshot);
+  }
+  rocksdb_batched_multi_get_cf(obj->db, ro, cf->handle,
+    n, c_keys, c_key_lens, values, errs, sorted_input);
+  if (snap_obj) {
+    rocksdb_readoptions_set_snapshot(ro, NULL);
+  }
+
+  array_init_size(return_value, (uint32_t)n);
+  for (i = 0; i < n; i++) {
+    zval val;
+    const char *v;
+    size_t val_len;
+    if (errs[i]) {
+      ZVAL_FALSE(&val);
+      rocksdb_free(errs[i]);
+    } else if (php_rocksdb_pinned_value(obj, &values[i], &v, &val_len)) {
+      if (!decode) {
+        ZVAL_STRINGL(&val, v, val_len);
+      } else if (php_rocksdb_codec_decode(v, val_len, &val) == FAILURE) {
+        /* Reported like a per-key read error */
+        zend_clear_exception();
+        ZVAL_FALSE(&val);
+      }
+      rocksdb_pinnableslice_destroy(values[i]);
+    } else {
+      ZVAL_NULL(&val);
+    }
+    zend_symtable_update(Z_ARRVAL_P(return_value), keys[i], &val);
+    zend_string_release(keys[i]);
+  }
+
+  efree(keys);
+  efree(c_keys);
+  efree(c_key_lens);
+  efree(values);
+  efree(errs);
+}
+
+/* public function RocksDB::multiGet(array $keys, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, bool $sortedInput = false, ?array $readOptions = null): array
+   Returns key => value in input order (null when missing, false on a
+   per-key error). $sortedInput promises the keys are already in ascending
+   byte order, which spares the engine its own sort. */
+PHP_METHOD(RocksDB, multiGet)
+{
+  php_rocksdb_multi_get(INTERNAL_FUNCTION_PARAM_PASSTHRU, 0);
+}
+
+/* public function RocksDB::multiGetValues(array $keys, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, bool $sortedInput = false, ?array $readOptions = null): array
+   multiGet() for putValue() values; a value that does not decode is false. */
+PHP_METHOD(RocksDB, multiGetValues)
+{
+  php_rocksdb_multi_get(INTERNAL_FUNCTION_PARAM_PASSTHRU, 1);
+}
+
+/* public function RocksDB::put(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null, ?int $ttlSeconds = null): bool
+   $ttlSeconds (needs the 'expiry_filter' option) makes the value expire:
+   reads hide it from then on and compactions drop it. */
+PHP_METHOD(RocksDB, put)
+{
+  char *key, *value;
+  size_t key_len, value_len;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *cf_zv = NULL, *write_options_zv = NULL;
+  rocksdb_writeoptions_t *wo;
+  rocksdb_column_family_object *cf_obj = NULL;
+  zend_long ttl = 0;
+  zend_bool ttl_is_null = 1;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!a!l!", &key, &key_len, &value, &value_len,
+      &cf_zv, php_rocksdb_column_family_ce, &write_options_zv, &ttl, &ttl_is_null) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  if (!ttl_is_null && !php_rocksdb_check_ttl(obj, ttl)) {
+    return;
+  }
+  wo = php_rocksdb_call_write_options(obj, write_options_zv);
+
+  php_rocksdb_put(obj, wo, cf_obj, key, key_len, value, value_len, ttl_is_null ? 0 : ttl, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::putValue(string $key, mixed $value, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null, ?int $ttlSeconds = null): bool
+   Stores null, bool, int, float, string or (nested) array values in the
+   extension's compact binary format; read them back with getValue(),
+   multiGetValues() or a decoding iterator. */
+PHP_METHOD(RocksDB, putValue)
+{
+  char *key;
+  size_t key_len;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *value_zv, *cf_zv = NULL, *write_options_zv = NULL;
+  rocksdb_writeoptions_t *wo;
+  rocksdb_column_family_object *cf_obj = NULL;
+  smart_str buf = {0};
+  zend_long ttl = 0;
+  zend_bool ttl_is_null = 1;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "sz|O!a!l!", &key, &key_len, &value_zv,
+      &cf_zv, php_rocksdb_column_family_ce, &write_options_zv, &ttl, &ttl_is_null) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  if (!ttl_is_null && !php_rocksdb_check_ttl(obj, ttl)) {
+    return;
+  }
+  if (php_rocksdb_codec_encode(&buf, value_zv) == FAILURE) {
+    return;
+  }
+  wo = php_rocksdb_call_write_options(obj, write_options_zv);
+
+  php_rocksdb_put(obj, wo, cf_obj, key, key_len, ZSTR_VAL(buf.s), ZSTR_LEN(buf.s),
+    ttl_is_null ? 0 : ttl, &err);
+  smart_str_free(&buf);
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::merge(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool
+   Blind write of a merge operand; needs the 'merge_operator' option. */
+PHP_METHOD(RocksDB, merge)
+{
+  char *key, *value;
+  size_t key_len, value_len;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *cf_zv = NULL, *write_options_zv = NULL;
+  rocksdb_writeoptions_t *wo;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!a!", &key, &key_len, &value, &value_len,
+      &cf_zv, php_rocksdb_column_family_ce, &write_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  if (php_rocksdb_expiry_reject(obj, value, value_len)) {
+    return;
+  }
+  wo = php_rocksdb_call_write_options(obj, write_options_zv);
+
+  if (obj->txn_db) {
+    if (cf_obj) {
+      rocksdb_transactiondb_merge_cf(obj->txn_db, wo, cf_obj->cf->handle,
+        key, key_len, value, value_len, &err);
+    } else {
+      rocksdb_transactiondb_merge(obj->txn_db, wo, key, key_len, value, value_len, &err);
+    }
+  } else if (cf_obj) {
+    rocksdb_merge_cf(obj->db, wo, cf_obj->cf->handle,
+      key, key_len, value, value_len, &err);
+  } else {
+    rocksdb_merge(obj->db, wo, key, key_len, value, value_len, &err);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::delete(string $key, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool */
+PHP_METHOD(RocksDB, delete)
+{
+  char *key;
+  size_t key_len;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *cf_zv = NULL, *write_options_zv = NULL;
+  rocksdb_writeoptions_t *wo;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!a!", &key, &key_len,
+      &cf_zv, php_rocksdb_column_family_ce, &write_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  wo = php_rocksdb_call_write_options(obj, write_options_zv);
+
+  if (obj->txn_db) {
+    if (cf_obj) {
+      rocksdb_transactiondb_delete_cf(obj->txn_db, wo, cf_obj->cf->handle, key, key_len, &err);
+    } else {
+      rocksdb_transactiondb_delete(obj->txn_db, wo, key, key_len, &err);
+    }
+  } else if (cf_obj) {
+    rocksdb_delete_cf(obj->db, wo, cf_obj->cf->handle, key, key_len, &err);
+  } else {
+    rocksdb_delete(obj->db, wo, key, key_len, &err);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* TransactionDB rejects range deletions, as write() of a batch holding one
+   does; writing them to the base DB would bypass the row locks. Throws and
+   returns 1 on a pessimistic DB. */
+static zend_bool php_rocksdb_delete_range_unsupported(rocksdb_object *obj) {
+  if (obj->txn_db) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Range deletion is not supported on a pessimistic transaction DB", 0);
+    return 1;
+  }
+  return 0;
+}
+
+/* One range tombstone over [start, end) */
+static void php_rocksdb_delete_range(rocksdb_object *obj, rocksdb_writeoptions_t *wo,
+    rocksdb_column_family_object *cf_obj, const char *start, size_t start_len,
+    const char *end, size_t end_len, char **err) {
+  php_rocksdb_column_family *cf = cf_obj ? cf_obj->cf
+    : zend_hash_str_find_ptr(obj->column_families, "default", sizeof("default") - 1);
+
+  rocksdb_delete_range_cf(obj->db, wo, cf->handle, start, start_len, end, end_len, err);
+}
+
+/* public function RocksDB::deleteRange(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool
+   Deletes every key in [start, end) with a single range tombstone instead
+   of one tombstone per key. */
+PHP_METHOD(RocksDB, deleteRange)
+{
+  char *start, *end;
+  size_t start_len, end_len;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *cf_zv = NULL, *write_options_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!a!", &start, &start_len, &end, &end_len,
+      &cf_zv, php_rocksdb_column_family_ce, &write_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  if (php_rocksdb_delete_range_unsupported(obj)) {
+    return;
+  }
+
+  php_rocksdb_delete_range(obj, php_rocksdb_call_write_options(obj, write_options_zv),
+    cf_obj, start, start_len, end, end_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::deletePrefix(string $prefix, ?RocksDBColumnFamily $columnFamily = null, ?array $writeOptions = null): bool
+   deleteRange() over every key starting with $prefix. */
+PHP_METHOD(RocksDB, deletePrefix)
+{
+  char *prefix, *end;
+  size_t prefix_len, end_len = 0;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *cf_zv = NULL, *write_options_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!a!", &prefix, &prefix_len,
+      &cf_zv, php_rocksdb_column_family_ce, &write_options_zv) == FAILURE) {
+    return;
+  }
+  if (prefix_len == 0) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Prefix must not be empty; use deleteRange() to clear a whole range", 0);
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  if (php_rocksdb_delete_range_unsupported(obj)) {
+    return;
+  }
+
+  end = php_rocksdb_prefix_end(obj->db, cf_obj ? cf_obj->cf->handle : NULL,
+    prefix, prefix_len, &end_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
+  if (!end) {
+    /* Nothing at or past the prefix */
+    RETURN_TRUE;
+  }
+
+  php_rocksdb_delete_range(obj, php_rocksdb_call_write_options(obj, write_options_zv),
+    cf_obj, prefix, prefix_len, end, end_len, &err);
+  efree(end);
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::deleteFilesInRange(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null): bool
+   Drops the SST files whose keys all fall in [start, end] without writing
+   anything. Keys in memtables or in files only partly inside the range
+   survive; pair it with deleteRange() to remove everything. Bypasses
+   snapshots. */
+PHP_METHOD(RocksDB, deleteFilesInRange)
+{
+  char *start, *end;
+  size_t start_len, end_len;
+  char *err = NULL;
+  rocksdb_object *obj;
+  zval *cf_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!", &start, &start_len, &end, &end_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  if (cf_obj) {
+    rocksdb_delete_file_in_range_cf(obj->db, cf_obj->cf->handle,
+      start, start_len, end, end_len, &err);
+  } else {
+    rocksdb_delete_file_in_range(obj->db, start, start_len, end, end_len, &err);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::write(RocksDBWriteBatch $batch, ?array $writeOptions = null): bool */
+PHP_METHOD(RocksDB, write)
+{
+  zval *batch_zv;
+  zval *writeoptions_zv = NULL;
+  char *err = NULL;
+  rocksdb_object *obj;
+  rocksdb_write_batch_object *batch_obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O|a!",
+      &batch_zv, php_rocksdb_write_batch_ce, &writeoptions_zv) == FAILURE) {
+    return;
+  }
+
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  batch_obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(batch_zv));
+  if (obj->expiry_filter && batch_obj->expiry_ambiguous) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Write batch holds a value starting with the expiry header bytes (0xFE 0xE7); use put() on a DB with 'expiry_filter'", 0);
+    return;
+  }
+
+  if (obj->txn_db) {
+    rocksdb_transactiondb_write(obj->txn_db, php_rocksdb_call_write_options(obj, writeoptions_zv),
+      batch_obj->batch, &err);
+  } else {
+    rocksdb_write(obj->db, php_rocksdb_call_write_options(obj, writeoptions_zv),
+      batch_obj->batch, &err);
+  }
+
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::getIterator(?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator */
+PHP_METHOD(RocksDB, getIterator)
+{
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_object *obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|O!O!a!",
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  object_init_ex(return_value, php_rocksdb_iterator_ce);
+  php_rocksdb_iterator_init(
+    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(return_value)), obj,
+    NULL, 0, NULL, 0, NULL, 0, snap_obj, cf_obj, read_options_zv);
+}
+
+/* public function RocksDB::prefixSearch(string $prefix, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator */
+PHP_METHOD(RocksDB, prefixSearch)
+{
+  char *prefix;
+  size_t prefix_len;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_object *obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!O!a!", &prefix, &prefix_len,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  object_init_ex(return_value, php_rocksdb_iterator_ce);
+  php_rocksdb_iterator_init(
+    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(return_value)), obj,
+    prefix, prefix_len, NULL, 0, NULL, 0, snap_obj, cf_obj, read_options_zv);
+}
+
+/* public function RocksDB::getColumnFamily(string $name): RocksDBColumnFamily */
+PHP_METHOD(RocksDB, getColumnFamily)
+{
+  char *name;
+  size_t name_len;
+  rocksdb_object *obj;
+  php_rocksdb_column_family *cf;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &name, &name_len) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  cf = zend_hash_str_find_ptr(obj->column_families, name, name_len);
+  if (!cf) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Column family '%s' does not exist", name);
+    return;
+  }
+  php_rocksdb_column_family_object_init(return_value, obj, cf);
+}
+
+/* public function RocksDB::createColumnFamily(string $name, ?array $options = null): RocksDBColumnFamily
+   Starts from the RocksDB defaults plus $options; list the family under
+   'column_families' on later opens to keep those settings. */
+PHP_METHOD(RocksDB, createColumnFamily)
+{
+  char *name;
+  size_t name_len;
+  zval *options_zv = NULL;
+  char *err = NULL;
+  rocksdb_object *obj;
+  rocksdb_options_t *cf_options;
+  php_rocksdb_column_family *cf;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|a!", &name, &name_len, &options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (zend_hash_str_exists(obj->column_families, name, name_len)) {
+    zend_throw_exception_ex(php_rocksdb_exception_ce, 0,
+      "Column family '%s' already exists", name);
+    return;
+  }
+
+  cf = php_rocksdb_column_family_create(name);
+  cf_options = php_rocksdb_column_family_options(NULL, options_zv, obj->block_cache, cf);
+  if (!cf_options) {
+    php_rocksdb_column_family_release(cf);
+    return;
+  }
+  /* A TransactionDB must also register the family with its lock manager */
+  cf->handle = obj->txn_db
+    ? rocksdb_transactiondb_create_column_family(obj->txn_db, cf_options, name, &err)
+    : rocksdb_create_column_family(obj->db, cf_options, name, &err);
+  rocksdb_options_destroy(cf_options);
+  if (err != NULL) {
+    php_rocksdb_column_family_release(cf);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+
+  zend_hash_str_update_ptr(obj->column_families, name, name_len, cf);
+  php_rocksdb_column_family_object_init(return_value, obj, cf);
+}
+
+/* public function RocksDB::dropColumnFamily(RocksDBColumnFamily $columnFamily): bool
+   Drops the family's data; handles still held keep working until released. */
+PHP_METHOD(RocksDB, dropColumnFamily)
+{
+  zval *cf_zv;
+  char *err = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O", &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (!(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  rocksdb_drop_column_family(obj->db, cf_obj->cf->handle, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  cf_obj->cf->dropped = 1;
+  zend_hash_str_del(obj->column_families, cf_obj->cf->name, strlen(cf_obj->cf->name));
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::ingestExternalFiles(array $paths, ?array $options = null, ?RocksDBColumnFamily $columnFamily = null): bool
+   Links (or copies) SST files built by RocksDBSstFileWriter into the LSM
+   tree, at the lowest level their key range allows. */
+PHP_METHOD(RocksDB, ingestExternalFiles)
+{
+  zval *paths_zv, *options_zv = NULL, *cf_zv = NULL, *zv;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_ingestexternalfileoptions_t *io;
+  rocksdb_object *obj;
+  HashTable *ht;
+  const char **files;
+  size_t n, i = 0;
+  char *err = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a|a!O!", &paths_zv, &options_zv,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  ht = Z_ARRVAL_P(paths_zv);
+  n = zend_hash_num_elements(ht);
+  if (!n) {
+    RETURN_TRUE;
+  }
+  files = emalloc(sizeof(char*) * n);
+  ZEND_HASH_FOREACH_VAL(ht, zv) {
+    ZVAL_DEREF(zv);
+    if (Z_TYPE_P(zv) != IS_STRING) {
+      efree(files);
+      zend_throw_exception(php_rocksdb_exception_ce, "File paths must be strings", 0);
+      return;
+    }
+    files[i++] = Z_STRVAL_P(zv);
+  } ZEND_HASH_FOREACH_END();
+
+  io = rocksdb_ingestexternalfileoptions_create();
+  if (options_zv) {
+    zval *val;
+    HashTable *oht = Z_ARRVAL_P(options_zv);
+
+    if ((val = zend_hash_str_find(oht, "move_files", sizeof("move_files") - 1)) != NULL) {
+      rocksdb_ingestexternalfileoptions_set_move_files(io, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(oht, "snapshot_consistency", sizeof("snapshot_consistency") - 1)) != NULL) {
+      rocksdb_ingestexternalfileoptions_set_snapshot_consistency(io, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(oht, "allow_global_seqno", sizeof("allow_global_seqno") - 1)) != NULL) {
+      rocksdb_ingestexternalfileoptions_set_allow_global_seqno(io, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(oht, "allow_blocking_flush", sizeof("allow_blocking_flush") - 1)) != NULL) {
+      rocksdb_ingestexternalfileoptions_set_allow_blocking_flush(io, zend_is_true(val));
+    }
+    if ((val = zend_hash_str_find(oht, "ingest_behind", sizeof("ingest_behind") - 1)) != NULL) {
+      rocksdb_ingestexternalfileoptions_set_ingest_behind(io, zend_is_true(val));
+    }
+  }
+
+  if (cf_obj) {
+    rocksdb_ingest_external_file_cf(obj->db, cf_obj->cf->handle, files, n, io, &err);
+  } else {
+    rocksdb_ingest_external_file(obj->db, files, n, io, &err);
+  }
+  rocksdb_ingestexternalfileoptions_destroy(io);
+  efree(files);
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function RocksDB::listColumnFamilies(): array */
+PHP_METHOD(RocksDB, listColumnFamilies)
+{
+  rocksdb_object *obj;
+  zend_string *name;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  array_init_size(return_value, zend_hash_num_elements(obj->column_families));
+  ZEND_HASH_FOREACH_STR_KEY(obj->column_families, name) {
+    add_next_index_str(return_value, zend_string_copy(name));
+  } ZEND_HASH_FOREACH_END();
+}
+
+/* public function RocksDB::getSnapshot(): RocksDBSnapshot */
+PHP_METHOD(RocksDB, getSnapshot)
+{
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  object_init_ex(return_value, php_rocksdb_snapshot_ce);
+  php_rocksdb_snapshot_init(
+    php_rocksdb_snapshot_object_from_zobj(Z_OBJ_P(return_value)),
+    php_rocksdb_object_from_zobj(Z_OBJ_P(getThis())));
+}
+
+/* public function RocksDB::getSnapshotStats(): array
+   Live snapshot count and the age of the oldest one; long-lived snapshots
+   keep compaction from dropping the versions they pin. */
+PHP_METHOD(RocksDB, getSnapshotStats)
+{
+  rocksdb_object *obj;
+  uint64_t count = 0, oldest_time = 0;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  rocksdb_property_int(obj->db, "rocksdb.num-snapshots", &count);
+  rocksdb_property_int(obj->db, "rocksdb.oldest-snapshot-time", &oldest_time);
+
+  array_init_size(return_value, 3);
+  add_assoc_long(return_value, "count", (zend_long)count);
+  add_assoc_long(return_value, "oldest_time", (zend_long)oldest_time);
+  add_assoc_long(return_value, "oldest_age",
+    oldest_time ? (zend_long)time(NULL) - (zend_long)oldest_time : 0);
+}
+
+/* public function RocksDB::getProperty(string $name): string|null */
+PHP_METHOD(RocksDB, getProperty)
+{
+  char *name;
+  size_t name_len;
+  rocksdb_object *obj;
+  char *val;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &name, &name_len) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  val = rocksdb_property_value(obj->db, name);
+  if (!val) {
+    RETURN_NULL();
+  }
+  RETVAL_STRING(val);
+  rocksdb_free(val);
+}
+
+/* One integer property, null when the property is not available */
+static void php_rocksdb_int_property(zval *return_value, rocksdb_object *obj,
+    rocksdb_column_family_object *cf_obj, const char *name)
+{
+  uint64_t val;
+  int rc;
+
+  if (cf_obj) {
+    rc = rocksdb_property_int_cf(obj->db, cf_obj->cf->handle, name, &val);
+  } else {
+    rc = rocksdb_property_int(obj->db, name, &val);
+  }
+  if (rc != 0) {
+    RETURN_NULL();
+  }
+  RETURN_LONG((zend_long)val);
+}
+
+/* public function RocksDB::getIntProperty(string $name, ?RocksDBColumnFamily $columnFamily = null): ?int
+   Numeric properties (e.g. rocksdb.estimate-num-keys) without string parsing */
+PHP_METHOD(RocksDB, getIntProperty)
+{
+  char *name;
+  size_t name_len;
+  zval *cf_zv = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!", &name, &name_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  php_rocksdb_int_property(return_value, obj, cf_obj, name);
+}
+
+/* public function RocksDB::getMapProperty(string $name, ?RocksDBColumnFamily $columnFamily = null): ?array
+   Map properties (e.g. rocksdb.aggregated-table-properties) as key => value.
+   The C API has no GetMapProperty(), so this parses the property's text form. */
+PHP_METHOD(RocksDB, getMapProperty)
+{
+  char *name;
+  size_t name_len;
+  zval *cf_zv = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  char *val;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!", &name, &name_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  if (cf_obj) {
+    val = rocksdb_property_value_cf(obj->db, cf_obj->cf->handle, name);
+  } else {
+    val = rocksdb_property_value(obj->db, name);
+  }
+  if (!val) {
+    RETURN_NULL();
+  }
+  php_rocksdb_parse_map_property(return_value, val);
+  rocksdb_free(val);
+}
+
+/* Shared by the typed size accessors: the fixed integer property 'name' */
+static void php_rocksdb_size_property(INTERNAL_FUNCTION_PARAMETERS, const char *name)
+{
+  zval *cf_zv = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|O!", &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  php_rocksdb_int_property(return_value, obj, cf_obj, name);
+}
+
+/* public function RocksDB::getEstimatedNumKeys(?RocksDBColumnFamily $columnFamily = null): ?int
+   rocksdb.estimate-num-keys: memtables plus SSTs, minus deletions seen so
+   far; overwrites and merges make it an upper bound */
+PHP_METHOD(RocksDB, getEstimatedNumKeys)
+{
+  php_rocksdb_size_property(INTERNAL_FUNCTION_PARAM_PASSTHRU, "rocksdb.estimate-num-keys");
+}
+
+/* public function RocksDB::getEstimatedLiveDataSize(?RocksDBColumnFamily $columnFamily = null): ?int
+   rocksdb.estimate-live-data-size: bytes of live data in SSTs */
+PHP_METHOD(RocksDB, getEstimatedLiveDataSize)
+{
+  php_rocksdb_size_property(INTERNAL_FUNCTION_PARAM_PASSTHRU, "rocksdb.estimate-live-data-size");
+}
+
+/* public function RocksDB::getTotalSstFilesSize(?RocksDBColumnFamily $columnFamily = null): ?int
+   rocksdb.total-sst-files-size: every SST version still referenced */
+PHP_METHOD(RocksDB, getTotalSstFilesSize)
+{
+  php_rocksdb_size_property(INTERNAL_FUNCTION_PARAM_PASSTHRU, "rocksdb.total-sst-files-size");
+}
+
+/* public function RocksDB::getLevelStats(?RocksDBColumnFamily $columnFamily = null): array
+   level => ['files' => int, 'size' => bytes] for every LSM level, from the
+   column family metadata (no property text to parse) */
+PHP_METHOD(RocksDB, getLevelStats)
+{
+  zval *cf_zv = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_column_family_metadata_t *meta;
+  size_t levels, i;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|O!", &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+
+  meta = cf_obj
+    ? rocksdb_get_column_family_metadata_cf(obj->db, cf_obj->cf->handle)
+    : rocksdb_get_column_family_metadata(obj->db);
+  levels = rocksdb_column_family_metadata_get_level_count(meta);
+
+  array_init_size(return_value, (uint32_t)levels);
+  for (i = 0; i < levels; i++) {
+    rocksdb_level_metadata_t *level = rocksdb_column_family_metadata_get_level_metadata(meta, i);
+    zval stats;
+
+    array_init_size(&stats, 2);
+    add_assoc_long(&stats, "files", (zend_long)rocksdb_level_metadata_get_file_count(level));
+    add_assoc_long(&stats, "size", (zend_long)rocksdb_level_metadata_get_size(level));
+    add_index_zval(return_value, rocksdb_level_metadata_get_level(level), &stats);
+    rocksdb_level_metadata_destroy(level);
+  }
+  rocksdb_column_family_metadata_destroy(meta);
+}
+
+/* public function RocksDB::approximateSizes(array $ranges, bool $includeMemtables = false, ?RocksDBColumnFamily $columnFamily = null): array
+   Estimated on-disk bytes per range from the SST index blocks, without
+   reading data. Each entry is [start, end) as a two-element array or a
+   string prefix; the result keeps the input keys. $includeMemtables adds
+   the memtables' share (approximateMemtableStats()). */
+PHP_METHOD(RocksDB, approximateSizes)
+{
+  zval *ranges_zv, *range, *bound;
+  zend_bool include_memtables = 0;
+  zval *cf_zv = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  php_rocksdb_column_family *cf;
+  HashTable *ht;
+  uint32_t n, i = 0;
+  const char **starts, **limits;
+  size_t *start_lens, *limit_lens;
+  char **successors;
+  uint64_t *sizes;
+  zend_ulong idx;
+  zend_string *key;
+  char *err = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a|bO!", &ranges_zv, &include_memtables,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  cf = cf_obj ? cf_obj->cf
+    : zend_hash_str_find_ptr(obj->column_families, "default", sizeof("default") - 1);
+
+  ht = Z_ARRVAL_P(ranges_zv);
+  n = zend_hash_num_elements(ht);
+  if (!n) {
+    RETURN_EMPTY_ARRAY();
+  }
+
+  /* Validate first so nothing needs unwinding afterwards */
+  ZEND_HASH_FOREACH_VAL(ht, range) {
+    ZVAL_DEREF(range);
+    if (Z_TYPE_P(range) == IS_STRING) {
+      continue;
+    }
+    if (Z_TYPE_P(range) != IS_ARRAY || zend_hash_num_elements(Z_ARRVAL_P(range)) != 2
+        || (bound = zend_hash_index_find(Z_ARRVAL_P(range), 0)) == NULL || Z_TYPE_P(bound) != IS_STRING
+        || (bound = zend_hash_index_find(Z_ARRVAL_P(range), 1)) == NULL || Z_TYPE_P(bound) != IS_STRING) {
+      zend_throw_exception(php_rocksdb_exception_ce,
+        "Each range must be [string $start, string $end] or a string prefix", 0);
+      return;
+    }
+  } ZEND_HASH_FOREACH_END();
+
+  starts     = emalloc(sizeof(char*) * n);
+  start_lens = emalloc(sizeof(size_t) * n);
+  limits     = emalloc(sizeof(char*) * n);
+  limit_lens = emalloc(sizeof(size_t) * n);
+  successors = ecalloc(n, sizeof(char*));
+  sizes      = ecalloc(n, sizeof(uint64_t));
+
+  ZEND_HASH_FOREACH_VAL(ht, range) {
+    ZVAL_DEREF(range);
+    if (Z_TYPE_P(range) == IS_STRING) {
+      starts[i] = Z_STRVAL_P(range);
+      start_lens[i] = Z_STRLEN_P(range);
+      successors[i] = php_rocksdb_prefix_end(obj->db, cf->handle,
+        Z_STRVAL_P(range), Z_STRLEN_P(range), &limit_lens[i], &err);
+      if (err != NULL) {
+        break;
+      }
+      if (successors[i]) {
+        limits[i] = successors[i];
+      } else {
+        /* Nothing at or past the prefix: an empty range */
+        limits[i] = starts[i];
+        limit_lens[i] = start_lens[i];
+      }
+    } else {
+      bound = zend_hash_index_find(Z_ARRVAL_P(range), 0);
+      starts[i] = Z_STRVAL_P(bound);
+      start_lens[i] = Z_STRLEN_P(bound);
+      bound = zend_hash_index_find(Z_ARRVAL_P(range), 1);
+      limits[i] = Z_STRVAL_P(bound);
+      limit_lens[i] = Z_STRLEN_P(bound);
+    }
+    i++;
+  } ZEND_HASH_FOREACH_END();
+
+  if (err == NULL) {
+    rocksdb_approximate_sizes_cf(obj->db, cf->handle, (int)n, starts, start_lens,
+      limits, limit_lens, sizes, &err);
+  }
+  if (err == NULL && include_memtables) {
+    for (i = 0; i < n; i++) {
+      uint64_t count = 0, size = 0;
+      rocksdb_approximate_memtable_stats_cf(obj->db, cf->handle,
+        starts[i], start_lens[i], limits[i], limit_lens[i], &count, &size);
+      sizes[i] += size;
+    }
+  }
+
+  if (err == NULL) {
+    array_init_size(return_value, n);
+    i = 0;
+    ZEND_HASH_FOREACH_KEY(ht, idx, key) {
+      if (key) {
+        add_assoc_long_ex(return_value, ZSTR_VAL(key), ZSTR_LEN(key), (zend_long)sizes[i]);
+      } else {
+        add_index_long(return_value, idx, (zend_long)sizes[i]);
+      }
+      i++;
+    } ZEND_HASH_FOREACH_END();
+  }
+
+  for (i = 0; i < n; i++) {
+    if (successors[i]) {
+      efree(successors[i]);
+    }
+  }
+  efree(starts);
+  efree(start_lens);
+  efree(limits);
+  efree(limit_lens);
+  efree(successors);
+  efree(sizes);
+  ROCKSDB_CHECK_ERROR(err);
+}
+
+/* public function RocksDB::approximateMemtableStats(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null): array
+   ['count' => entries, 'size' => bytes] of [start, end) still in memtables,
+   the part approximateSizes() leaves out by default */
+PHP_METHOD(RocksDB, approximateMemtableStats)
+{
+  char *start, *end;
+  size_t start_len, end_len;
+  zval *cf_zv = NULL;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  php_rocksdb_column_family *cf;
+  uint64_t count = 0, size = 0;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!", &start, &start_len, &end, &end_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  cf = cf_obj ? cf_obj->cf
+    : zend_hash_str_find_ptr(obj->column_families, "default", sizeof("default") - 1);
+
+  rocksdb_approximate_memtable_stats_cf(obj->db, cf->handle,
+    start, start_len, end, end_len, &count, &size);
+
+  array_init_size(return_value, 2);
+  add_assoc_long(return_value, "count", (zend_long)count);
+  add_assoc_long(return_value, "size", (zend_long)size);
+}
+
+/* public function RocksDB::getStatistics(): array
+   Every ticker as an int and every histogram as
+   [p50, p95, p99, max, count, sum]; needs 'enable_statistics' at open */
+PHP_METHOD(RocksDB, getStatistics)
+{
+  rocksdb_object *obj;
+  char *stats;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  stats = rocksdb_options_statistics_get_string(obj->options);
+  if (!stats) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Statistics are not enabled, open the database with 'enable_statistics'", 0);
+    return;
+  }
+  php_rocksdb_parse_statistics(return_value, stats);
+  rocksdb_free(stats);
+}
+
+/* public static function RocksDB::setPerfLevel(int $level): void
+   Applies to the calling thread only */
+PHP_METHOD(RocksDB, setPerfLevel)
+{
+  zend_long level;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &level) == FAILURE) {
+    return;
+  }
+  php_rocksdb_set_perf_level(level);
+}
+
+/* public static function RocksDB::resetPerfContext(): void */
+PHP_METHOD(RocksDB, resetPerfContext)
+{
+  rocksdb_perfcontext_t *ctx;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ctx = rocksdb_perfcontext_create();
+  rocksdb_perfcontext_reset(ctx);
+  rocksdb_perfcontext_destroy(ctx);
+}
+
+/* public static function RocksDB::getPerfContext(bool $excludeZero = false): array
+   This thread's counters since the last reset */
+PHP_METHOD(RocksDB, getPerfContext)
+{
+  zend_bool exclude_zero = 0;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|b", &exclude_zero) == FAILURE) {
+    return;
+  }
+  php_rocksdb_perf_context(return_value, exclude_zero);
+}
+
+/* public static function RocksDB::profile(callable $fn, int $level = RocksDB::PERF_ENABLE_TIME_EXCEPT_FOR_MUTEX, bool $excludeZero = false): array
+   Runs $fn with perf counters at $level, restores the previous level and
+   returns the counters for that block only. Exceptions from $fn propagate. */
+PHP_METHOD(RocksDB, profile)
+{
+  zend_fcall_info fci;
+  zend_fcall_info_cache fcc;
+  zend_long level = rocksdb_enable_time_except_for_mutex;
+  zend_bool exclude_zero = 0;
+  int prev_level;
+  rocksdb_perfcontext_t *ctx;
+  zval retval;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "f|lb", &fci, &fcc,
+      &level, &exclude_zero) == FAILURE) {
+    return;
+  }
+
+  prev_level = ROCKSDB_G(perf_level);
+  if (!php_rocksdb_set_perf_level(level)) {
+    return;
+  }
+  ctx = rocksdb_perfcontext_create();
+  rocksdb_perfcontext_reset(ctx);
+  rocksdb_perfcontext_destroy(ctx);
+
+  ZVAL_UNDEF(&retval);
+  fci.retval = &retval;
+  zend_call_function(&fci, &fcc);
+  zval_ptr_dtor(&retval);
+
+  php_rocksdb_perf_context(return_value, exclude_zero);
+  rocksdb_set_perf_level(prev_level);
+  ROCKSDB_G(perf_level) = prev_level;
+}
+
+/* public function RocksDB::beginTransaction(?array $options = null, ?array $writeOptions = null): RocksDBTransaction
+   Needs a DB opened with 'transaction_db'. Options: set_snapshot (reads and
+   conflict checks as of begin); pessimistic only: lock_timeout (ms),
+   deadlock_detect, deadlock_detect_depth, expiration (ms). $writeOptions
+   apply to commit(). */
+PHP_METHOD(RocksDB, beginTransaction)
+{
+  zval *options_zv = NULL, *write_options_zv = NULL, *val;
+  rocksdb_object *obj;
+  rocksdb_transaction_object *txn_obj;
+  rocksdb_writeoptions_t *wo;
+  HashTable *ht = NULL;
+  zend_bool set_snapshot = 0;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|a!a!", &options_zv, &write_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (!obj->txn_db && !obj->otxn_db) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Transactions need a DB opened with the 'transaction_db' option", 0);
+    return;
+  }
+  if (options_zv) {
+    ht = Z_ARRVAL_P(options_zv);
+    if ((val = zend_hash_str_find(ht, "set_snapshot", sizeof("set_snapshot") - 1)) != NULL) {
+      set_snapshot = zend_is_true(val);
+    }
+  }
+  wo = php_rocksdb_call_write_options(obj, write_options_zv);
+
+  object_init_ex(return_value, php_rocksdb_transaction_ce);
+  txn_obj = php_rocksdb_transaction_object_from_zobj(Z_OBJ_P(return_value));
+
+  if (obj->txn_db) {
+    rocksdb_transaction_options_t *txn_options = rocksdb_transaction_options_create();
+    rocksdb_transaction_options_set_set_snapshot(txn_options, set_snapshot);
+    if (ht) {
+      if ((val = zend_hash_str_find(ht, "lock_timeout", sizeof("lock_timeout") - 1)) != NULL) {
+        rocksdb_transaction_options_set_lock_timeout(txn_options, zval_get_long(val));
+      }
+      if ((val = zend_hash_str_find(ht, "deadlock_detect", sizeof("deadlock_detect") - 1)) != NULL) {
+        rocksdb_transaction_options_set_deadlock_detect(txn_options, zend_is_true(val));
+      }
+      if ((val = zend_hash_str_find(ht, "deadlock_detect_depth", sizeof("deadlock_detect_depth") - 1)) != NULL) {
+        rocksdb_transaction_options_set_deadlock_detect_depth(txn_options, zval_get_long(val));
+      }
+      if ((val = zend_hash_str_find(ht, "expiration", sizeof("expiration") - 1)) != NULL) {
+        rocksdb_transaction_options_set_expiration(txn_options, zval_get_long(val));
+      }
+    }
+    txn_obj->txn = rocksdb_transaction_begin(obj->txn_db, wo, txn_options, NULL);
+    rocksdb_transaction_options_destroy(txn_options);
+  } else {
+    rocksdb_optimistictransaction_options_t *txn_options =
+      rocksdb_optimistictransaction_options_create();
+    rocksdb_optimistictransaction_options_set_set_snapshot(txn_options, set_snapshot);
+    txn_obj->txn = rocksdb_optimistictransaction_begin(obj->otxn_db, wo, txn_options, NULL);
+    rocksdb_optimistictransaction_options_destroy(txn_options);
+  }
+
+  txn_obj->db_obj = obj;
+  GC_ADDREF(&obj->std);
+  if (set_snapshot) {
+    txn_obj->snapshot = rocksdb_transaction_get_snapshot(txn_obj->txn);
+  }
+}
+
+/* public function RocksDB::getCacheStats(): array */
+PHP_METHOD(RocksDB, getCacheStats)
+{
+  rocksdb_object *obj;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  array_init(return_value);
+  if (obj->block_cache) {
+    php_rocksdb_add_cache_stats(return_value, "block_cache", obj->block_cache);
+  }
+  if (obj->row_cache) {
+    php_rocksdb_add_cache_stats(return_value, "row_cache", obj->row_cache);
+  }
+}
+
+/* public function RocksDB::scan(?string $start = null, ?string $end = null, int $limit = 0, bool $reverse = false, ?array $readOptions = null): array
+   Walks [start, end) in C, from the end when $reverse, and returns up to
+   $limit entries (0 = no limit) as key => value. */
+PHP_METHOD(RocksDB, scan)
+{
+  char *start = NULL, *end = NULL;
+  size_t start_len = 0, end_len = 0;
+  zend_long limit = 0;
+  zend_bool reverse = 0;
+  zval *read_options_zv = NULL;
+  char *err = NULL;
+  rocksdb_object *obj;
+  rocksdb_readoptions_t *ro;
+  rocksdb_iterator_t *iter;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|s!s!lba!",
+      &start, &start_len, &end, &end_len, &limit, &reverse, &read_options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+
+  ro = rocksdb_readoptions_create();
+  php_rocksdb_readoptions_apply(ro, &obj->read_options_defaults);
+  php_rocksdb_readoptions_apply(ro, read_options_zv);
+  if (start) {
+    rocksdb_readoptions_set_iterate_lower_bound(ro, start, start_len);
+  }
+  if (end) {
+    rocksdb_readoptions_set_iterate_upper_bound(ro, end, end_len);
+  }
+  if (obj->prefix_extractor != PHP_ROCKSDB_PREFIX_NONE) {
+    rocksdb_readoptions_set_total_order_seek(ro, 1);
+  }
+  iter = rocksdb_create_iterator(obj->db, ro);
+
+  array_init_size(return_value, limit > 0 && limit < 1024 ? (uint32_t)limit : 1024);
+  if (reverse) {
+    rocksdb_iter_seek_to_last(iter);
+  } else {
+    rocksdb_iter_seek_to_first(iter);
+  }
+  while (rocksdb_iter_valid(iter)
+      && (limit <= 0 || (zend_long)zend_hash_num_elements(Z_ARRVAL_P(return_value)) < limit)) {
+    size_t key_len, val_len;
+    const char *key = rocksdb_iter_key(iter, &key_len);
+    const char *val = rocksdb_iter_value(iter, &val_len);
+    if (!obj->expiry_filter || !php_rocksdb_expiry_strip(&val, &val_len)) {
+      add_assoc_stringl_ex(return_value, key, key_len, val, val_len);
+    }
+    if (reverse) {
+      rocksdb_iter_prev(iter);
+    } else {
+      rocksdb_iter_next(iter);
+    }
+  }
+  rocksdb_iter_get_error(iter, &err);
+  rocksdb_iter_destroy(iter);
+  rocksdb_readoptions_destroy(ro);
+
+  if (err != NULL) {
+    zval_ptr_dtor(return_value);
+    ZVAL_UNDEF(return_value);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+}
+
+/* One parallelScan() shard. Runs on its own thread, so it only touches
+   RocksDB and malloc()ed memory, never the Zend allocator. */
+typedef struct _php_rocksdb_scan_shard {
+  rocksdb_t *db;
+  rocksdb_column_family_handle_t *cf;
+  const rocksdb_snapshot_t *snapshot;
+  int ops;
+  const char *lo;          /* [lo, hi), NULL = unbounded; owned by the caller */
+  size_t lo_len;
+  const char *hi;
+  size_t hi_len;
+  uint64_t count;
+  uint64_t key_bytes;
+  uint64_t value_bytes;
+  uint64_t checksum;
+  char *min_key;           /* malloc()ed */
+  size_t min_key_len;
+  char *max_key;
+  size_t max_key_len;
+  char *err;
+  zend_bool expiry;        /* skip expired entries, count values unframed */
+  uint64_t now;            /* one expiry cutoff for every shard */
+  pthread_t thread;
+  zend_bool started;
+} php_rocksdb_scan_shard;
+
+/* FNV-1a 64 of one record (key length, key, value). The shard checksum is
+   the wrapping sum of these, so the total does not depend on the split. */
+static uint64_t php_rocksdb_record_hash(const char *key, size_t key_len,
+    const char *val, size_t val_len) {
+  uint64_t h = 14695981039346656037ULL, n = key_len;
+  size_t i;
+
+  for (i = 0; i < sizeof(n); i++) {
+    h = (h ^ (unsigned char)(n >> (i * 8))) * 1099511628211ULL;
+  }
+  for (i = 0; i < key_len; i++) {
+    h = (h ^ (unsigned char)key[i]) * 1099511628211ULL;
+  }
+  for (i = 0; i < val_len; i++) {
+    h = (h ^ (unsigned char)val[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+static char *php_rocksdb_scan_copy_key(rocksdb_iterator_t *iter, size_t *len) {
+  const char *k = rocksdb_iter_key(iter, len);
+  char *copy = malloc(*len ? *len : 1);
+  memcpy(copy, k, *len);
+  return copy;
+}
+
+/* Moves off expired entries in the given direction */
+static void php_rocksdb_scan_skip_expired(php_rocksdb_scan_shard *shard,
+    rocksdb_iterator_t *iter, zend_bool backward) {
+  while (shard->expiry && rocksdb_iter_valid(iter)) {
+    size_t vlen;
+    const char *v = rocksdb_iter_value(iter, &vlen);
+    if (!php_rocksdb_expiry_strip_at(&v, &vlen, shard->now)) {
+      return;
+    }
+    if (backward) {
+      rocksdb_iter_prev(iter);
+    } else {
+      rocksdb_iter_next(iter);
+    }
+  }
+}
+
+static void *php_rocksdb_scan_shard_run(void *arg) {
+  php_rocksdb_scan_shard *shard = arg;
+  rocksdb_readoptions_t *ro = rocksdb_readoptions_create();
+  rocksdb_iterator_t *iter;
+
+  /* A full pass would only evict the working set; prefix extractors must
+     not limit it either */
+  rocksdb_readoptions_set_fill_cache(ro, 0);
+  rocksdb_readoptions_set_total_order_seek(ro, 1);
+  rocksdb_readoptions_set_snapshot(ro, shard->snapshot);
+  if (shard->lo) {
+    rocksdb_readoptions_set_iterate_lower_bound(ro, shard->lo, shard->lo_len);
+  }
+  if (shard->hi) {
+    rocksdb_readoptions_set_iterate_upper_bound(ro, shard->hi, shard->hi_len);
+  }
+  iter = shard->cf
+    ? rocksdb_create_iterator_cf(shard->db, ro, shard->cf)
+    : rocksdb_create_iterator(shard->db, ro);
+
+  rocksdb_iter_seek_to_first(iter);
+  php_rocksdb_scan_skip_expired(shard, iter, 0);
+  if ((shard->ops & PHP_ROCKSDB_SCAN_MIN_MAX) && rocksdb_iter_valid(iter)) {
+    shard->min_key = php_rocksdb_scan_copy_key(iter, &shard->min_key_len);
+  }
+  /* min/max alone needs no pass over the shard */
+  if (shard->ops & (PHP_ROCKSDB_SCAN_COUNT | PHP_ROCKSDB_SCAN_BYTES | PHP_ROCKSDB_SCAN_CHECKSUM)) {
+    for (; rocksdb_iter_valid(iter); rocksdb_iter_next(iter)) {
+      size_t klen, vlen = 0;
+      const char *k = rocksdb_iter_key(iter, &klen), *v = NULL;
+
+      if (shard->expiry) {
+        v = rocksdb_iter_value(iter, &vlen);
+        if (php_rocksdb_expiry_strip_at(&v, &vlen, shard->now)) {
+          continue;
+        }
+      }
+      shard->count++;
+      if (shard->ops & (PHP_ROCKSDB_SCAN_BYTES | PHP_ROCKSDB_SCAN_CHECKSUM)) {
+        if (!v) {
+          v = rocksdb_iter_value(iter, &vlen);
+        }
+        shard->key_bytes += klen;
+        shard->value_bytes += vlen;
+      }
+      if (shard->ops & PHP_ROCKSDB_SCAN_CHECKSUM) {
+        shard->checksum += php_rocksdb_record_hash(k, klen, v, vlen);
+      }
+    }
+  }
+  if ((shard->ops & PHP_ROCKSDB_SCAN_MIN_MAX) && shard->min_key) {
+    rocksdb_iter_seek_to_last(iter);
+    php_rocksdb_scan_skip_expired(shard, iter, 1);
+    if (rocksdb_iter_valid(iter)) {
+      shard->max_key = php_rocksdb_scan_copy_key(iter, &shard->max_key_len);
+    }
+  }
+  rocksdb_iter_get_error(iter, &shard->err);
+
+  rocksdb_iter_destroy(iter);
+  rocksdb_readoptions_destroy(ro);
+  return NULL;
+}
+
+typedef struct _php_rocksdb_split_key {
+  const char *key;
+  size_t len;
+} php_rocksdb_split_key;
+
+static int php_rocksdb_split_key_cmp(const void *a, const void *b) {
+  const php_rocksdb_split_key *x = a, *y = b;
+  int c = memcmp(x->key, y->key, MIN(x->len, y->len));
+  return c ? c : (x->len < y->len ? -1 : x->len > y->len);
+}
+
+/* Picks up to 'shards - 1' split keys inside (lo, hi) for balanced shards.
+   Candidates are the SST boundary keys of the family; each is weighted by
+   rocksdb_approximate_sizes() of [lo, candidate) and the ones closest to
+   the even byte quantiles win. Returns the number of keys written to
+   'splits' (estrndup()ed); fewer when the data has too few files. */
+static uint32_t php_rocksdb_split_range(rocksdb_t *db, rocksdb_column_family_handle_t *cf,
+    const char *cf_name, const char *lo, size_t lo_len, const char *hi, size_t hi_len,
+    uint32_t shards, char **splits, size_t *split_lens) {
+  const rocksdb_livefiles_t *files = rocksdb_livefiles(db);
+  int nfiles = rocksdb_livefiles_count(files), f;
+  php_rocksdb_split_key *cands = emalloc(sizeof(php_rocksdb_split_key) * (2 * nfiles + 1));
+  const char **starts = NULL, **limits = NULL;
+  size_t *start_lens = NULL, *limit_lens = NULL;
+  uint64_t *sizes = NULL, total;
+  char *max_key = NULL, *err = NULL;
+  size_t max_key_len = 0;
+  uint32_t ncands = 0, nsplits = 0, i, j;
+
+  for (f = 0; f < nfiles; f++) {
+    php_rocksdb_split_key k[2];
+    int side;
+
+    if (strcmp(rocksdb_livefiles_column_family_name(files, f), cf_name) != 0) {
+      continue;
+    }
+    k[0].key = rocksdb_livefiles_smallestkey(files, f, &k[0].len);
+    k[1].key = rocksdb_livefiles_largestkey(files, f, &k[1].len);
+    for (side = 0; side < 2; side++) {
+      if (lo && zend_binary_strcmp(k[side].key, k[side].len, lo, lo_len) <= 0) {
+        continue;
+      }
+      if (hi && zend_binary_strcmp(k[side].key, k[side].len, hi, hi_len) >= 0) {
+        continue;
+      }
+      cands[ncands++] = k[side];
+    }
+  }
+  if (ncands == 0 || shards < 2) {
+    goto done;
+  }
+  qsort(cands, ncands, sizeof(php_rocksdb_split_key), php_rocksdb_split_key_cmp);
+  for (i = 1, j = 1; i < ncands; i++) {
+    if (php_rocksdb_split_key_cmp(&cands[i], &cands[j - 1]) != 0) {
+      cands[j++] = cands[i];
+    }
+  }
+  ncands = j;
+
+  /* An open end is sized up to just past the largest candidate */
+  if (!hi) {
+    max_key_len = cands[ncands - 1].len + 1;
+    max_key = emalloc(max_key_len);
+    memcpy(max_key, cands[ncands - 1].key, max_key_len - 1);
+    max_key[max_key_len - 1] = '\0';
+    hi = max_key;
+    hi_len = max_key_len;
+  }
+
+  /* Range i is [lo, candidate i); the last one is the whole [lo, hi) */
+  starts = emalloc(sizeof(char*) * (ncands + 1));
+  start_lens = emalloc(sizeof(size_t) * (ncands + 1));
+  limits = emalloc(sizeof(char*) * (ncands + 1));
+  limit_lens = emalloc(sizeof(size_t) * (ncands + 1));
+  sizes = ecalloc(ncands + 1, sizeof(uint64_t));
+  for (i = 0; i <= ncands; i++) {
+    starts[i] = lo ? lo : "";
+    start_lens[i] = lo ? lo_len : 0;
+    limits[i] = i < ncands ? cands[i].key : hi;
+    limit_lens[i] = i < ncands ? cands[i].len : hi_len;
+  }
+  if (cf) {
+    rocksdb_approximate_sizes_cf(db, cf, (int)(ncands + 1), starts, start_lens,
+      limits, limit_lens, sizes, &err);
+  } else {
+    rocksdb_approximate_sizes(db, (int)(ncands + 1), starts, start_lens,
+      limits, limit_lens, sizes, &err);
+  }
+  if (err) {
+    rocksdb_free(err);
+    memset(sizes, 0, sizeof(uint64_t) * (ncands + 1));
+  }
+  total = sizes[ncands];
+
+  for (i = 1, j = 0; i < shards && j < ncands; i++) {
+    if (total > 0) {
+      uint64_t target = total / shards * i;
+      while (j < ncands && sizes[j] < target) {
+        j++;
+      }
+    } else {
+      /* Nothing flushed yet: spread over the candidates evenly */
+      uint32_t want = (uint32_t)((uint64_t)ncands * i / shards);
+      j = MAX(j, want);
+    }
+    if (j >= ncands) {
+      break;
+    }
+    splits[nsplits] = estrndup(cands[j].key, cands[j].len);
+    split_lens[nsplits] = cands[j].len;
+    nsplits++;
+    j++;
+  }
+
+done:
+  if (sizes) {
+    efree(starts);
+    efree(start_lens);
+    efree(limits);
+    efree(limit_lens);
+    efree(sizes);
+  }
+  if (max_key) {
+    efree(max_key);
+  }
+  efree(cands);
+  rocksdb_livefiles_destroy(files);
+  return nsplits;
+}
+
+static void php_rocksdb_scan_add_key(zval *arr, const char *name, const char *key, size_t len) {
+  if (key) {
+    add_assoc_stringl(arr, name, key, len);
+  } else {
+    add_assoc_null(arr, name);
+  }
+}
+
+static void php_rocksdb_scan_add_totals(zval *arr, int ops, uint64_t count,
+    uint64_t key_bytes, uint64_t value_bytes, uint64_t checksum) {
+  if (ops & (PHP_ROCKSDB_SCAN_COUNT | PHP_ROCKSDB_SCAN_BYTES | PHP_ROCKSDB_SCAN_CHECKSUM)) {
+    add_assoc_long(arr, "count", (zend_long)count);
+  }
+  if (ops & PHP_ROCKSDB_SCAN_BYTES) {
+    add_assoc_long(arr, "key_bytes", (zend_long)key_bytes);
+    add_assoc_long(arr, "value_bytes", (zend_long)value_bytes);
+  }
+  if (ops & PHP_ROCKSDB_SCAN_CHECKSUM) {
+    add_assoc_long(arr, "checksum", (zend_long)checksum);
+  }
+}
+
+/* public function RocksDB::parallelScan(?string $start = null, ?string $end = null, int $threads = 0, int $op = RocksDB::SCAN_COUNT, ?RocksDBColumnFamily $columnFamily = null, ?RocksDBSnapshot $snapshot = null): array
+   Aggregates [start, end) on native threads (0 = one per CPU), each on its
+   own iterator over one snapshot. $op is a mask of RocksDB::SCAN_* and
+   selects count, key_bytes/value_bytes, min_key/max_key and checksum (order
+   and split independent). 'shards' lists the per-shard ranges and results. */
+PHP_METHOD(RocksDB, parallelScan)
+{
+  char *start = NULL, *end = NULL;
+  size_t start_len = 0, end_len = 0, *split_lens;
+  zend_long threads = 0, ops = PHP_ROCKSDB_SCAN_COUNT;
+  zval *cf_zv = NULL, *snapshot_zv = NULL, shards_zv;
+  rocksdb_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  const rocksdb_snapshot_t *snapshot;
+  php_rocksdb_scan_shard *shards;
+  char **splits, *err = NULL;
+  uint32_t nsplits, nshards, i;
+  uint64_t count = 0, key_bytes = 0, value_bytes = 0, checksum = 0, now;
+  const char *min_key = NULL, *max_key = NULL;
+  size_t min_key_len = 0, max_key_len = 0;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|s!s!llO!O!",
+      &start, &start_len, &end, &end_len, &threads, &ops,
+      &cf_zv, php_rocksdb_column_family_ce,
+      &snapshot_zv, php_rocksdb_snapshot_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj))) {
+    return;
+  }
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, obj))) {
+    return;
+  }
+  if (ops <= 0 || (ops & ~PHP_ROCKSDB_SCAN_ALL)) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Scan operation must be a combination of RocksDB::SCAN_* flags", 0);
+    return;
+  }
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? cpus : 1;
+  }
+  threads = MIN(threads, PHP_ROCKSDB_SCAN_MAX_THREADS);
+
+  splits = emalloc(sizeof(char*) * threads);
+  split_lens = emalloc(sizeof(size_t) * threads);
+  nsplits = php_rocksdb_split_range(obj->db, cf_obj ? cf_obj->cf->handle : NULL,
+    cf_obj ? cf_obj->cf->name : "default", start, start_len, end, end_len,
+    (uint32_t)threads, splits, split_lens);
+  nshards = nsplits + 1;
+
+  snapshot = snap_obj ? snap_obj->snapshot : rocksdb_create_snapshot(obj->db);
+  shards = ecalloc(nshards, sizeof(php_rocksdb_scan_shard));
+  now = (uint64_t)time(NULL);
+  for (i = 0; i < nshards; i++) {
+    php_rocksdb_scan_shard *shard = &shards[i];
+    shard->db = obj->db;
+    shard->cf = cf_obj ? cf_obj->cf->handle : NULL;
+    shard->snapshot = snapshot;
+    shard->ops = (int)ops;
+    shard->expiry = obj->expiry_filter;
+    shard->now = now;
+    shard->lo = i == 0 ? start : splits[i - 1];
+    shard->lo_len = i == 0 ? start_len : split_lens[i - 1];
+    shard->hi = i == nsplits ? end : splits[i];
+    shard->hi_len = i == nsplits ? end_len : split_lens[i];
+    /* The first shard runs on this thread */
+    if (i > 0) {
+      shard->started = pthread_create(&shard->thread, NULL,
+        php_rocksdb_scan_shard_run, shard) == 0;
+    }
+  }
+  for (i = 0; i < nshards; i++) {
+    if (i == 0 || !shards[i].started) {
+      php_rocksdb_scan_shard_run(&shards[i]);
+    } else {
+      pthread_join(shards[i].thread, NULL);
+    }
+  }
+  if (!snap_obj) {
+    rocksdb_release_snapshot(obj->db, snapshot);
+  }
+
+  array_init(return_value);
+  array_init_size(&shards_zv, nshards);
+  for (i = 0; i < nshards; i++) {
+    php_rocksdb_scan_shard *shard = &shards[i];
+    zval shard_zv;
+
+    if (shard->err) {
+      if (!err) {
+        err = shard->err;
+      } else {
+        rocksdb_free(shard->err);
+      }
+    }
+    count += shard->count;
+    key_bytes += shard->key_bytes;
+    value_bytes += shard->value_bytes;
+    checksum += shard->checksum;
+    if (shard->min_key && !min_key) {
+      min_key = shard->min_key;
+      min_key_len = shard->min_key_len;
+    }
+    if (shard->max_key) {
+      max_key = shard->max_key;
+      max_key_len = shard->max_key_len;
+    }
+
+    array_init(&shard_zv);
+    php_rocksdb_scan_add_key(&shard_zv, "start", shard->lo, shard->lo_len);
+    php_rocksdb_scan_add_key(&shard_zv, "end", shard->hi, shard->hi_len);
+    php_rocksdb_scan_add_totals(&shard_zv, (int)ops, shard->count,
+      shard->key_bytes, shard->value_bytes, shard->checksum);
+    if (ops & PHP_ROCKSDB_SCAN_MIN_MAX) {
+      php_rocksdb_scan_add_key(&shard_zv, "min_key", shard->min_key, shard->min_key_len);
+      php_rocksdb_scan_add_key(&shard_zv, "max_key", shard->max_key, shard->max_key_len);
+    }
+    add_next_index_zval(&shards_zv, &shard_zv);
+  }
+  php_rocksdb_scan_add_totals(return_value, (int)ops, count, key_bytes, value_bytes, checksum);
+  if (ops & PHP_ROCKSDB_SCAN_MIN_MAX) {
+    php_rocksdb_scan_add_key(return_value, "min_key", min_key, min_key_len);
+    php_rocksdb_scan_add_key(return_value, "max_key", max_key, max_key_len);
+  }
+  add_assoc_zval(return_value, "shards", &shards_zv);
+
+  for (i = 0; i < nshards; i++) {
+    free(shards[i].min_key);
+    free(shards[i].max_key);
+  }
+  for (i = 0; i < nsplits; i++) {
+    efree(splits[i]);
+  }
+  efree(splits);
+  efree(split_lens);
+  efree(shards);
+
+  if (err != NULL) {
+    zval_ptr_dtor(return_value);
+    ZVAL_UNDEF(return_value);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+}
+
+/* ------------------- RocksDBWriteBatch Methods ------------------- */
+
+/* public function __construct() */
+PHP_METHOD(RocksDBWriteBatch, __construct)
+{
+  rocksdb_write_batch_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
+  obj->batch = rocksdb_writebatch_create();
+}
+
+/* public function put(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool */
+PHP_METHOD(RocksDBWriteBatch, put)
+{
+  char *key, *value;
+  size_t key_len, value_len;
+  rocksdb_write_batch_object *obj;
+  zval *cf_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!",
+      &key, &key_len, &value, &value_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, NULL))) {
+    return;
+  }
+  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
+  obj->expiry_ambiguous |= php_rocksdb_expiry_ambiguous(value, value_len);
+  if (cf_obj) {
+    rocksdb_writebatch_put_cf(obj->batch, cf_obj->cf->handle, key, key_len, value, value_len);
+  } else {
+    rocksdb_writebatch_put(obj->batch, key, key_len, value, value_len);
+  }
+
+  RETURN_TRUE;
+}
+
+/* public function merge(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool */
+PHP_METHOD(RocksDBWriteBatch, merge)
+{
+  char *key, *value;
+  size_t key_len, value_len;
+  rocksdb_write_batch_object *obj;
+  zval *cf_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!",
+      &key, &key_len, &value, &value_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, NULL))) {
+    return;
+  }
+  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
+  obj->expiry_ambiguous |= php_rocksdb_expiry_ambiguous(value, value_len);
+  if (cf_obj) {
+    rocksdb_writebatch_merge_cf(obj->batch, cf_obj->cf->handle, key, key_len, value, value_len);
+  } else {
+    rocksdb_writebatch_merge(obj->batch, key, key_len, value, value_len);
+  }
+
+  RETURN_TRUE;
+}
+
+/* public function delete(string $key, ?RocksDBColumnFamily $columnFamily = null): bool */
+PHP_METHOD(RocksDBWriteBatch, delete)
+{
+  char *key;
+  size_t key_len;
+  rocksdb_write_batch_object *obj;
+  zval *cf_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!", &key, &key_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, NULL))) {
+    return;
+  }
+  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_obj) {
+    rocksdb_writebatch_delete_cf(obj->batch, cf_obj->cf->handle, key, key_len);
+  } else {
+    rocksdb_writebatch_delete(obj->batch, key, key_len);
+  }
+
+  RETURN_TRUE;
+}
+
+/* public function deleteRange(string $start, string $end, ?RocksDBColumnFamily $columnFamily = null): bool
+   Range tombstone over [start, end); not accepted by pessimistic
+   transaction DBs. */
+PHP_METHOD(RocksDBWriteBatch, deleteRange)
+{
+  char *start, *end;
+  size_t start_len, end_len;
+  rocksdb_write_batch_object *obj;
+  zval *cf_zv = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!", &start, &start_len, &end, &end_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, NULL))) {
+    return;
+  }
+  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
+  if (cf_obj) {
+    rocksdb_writebatch_delete_range_cf(obj->batch, cf_obj->cf->handle,
+      start, start_len, end, end_len);
+  } else {
+    rocksdb_writebatch_delete_range(obj->batch, start, start_len, end, end_len);
+  }
+
+  RETURN_TRUE;
+}
+
+/* public function clear(): bool */
+PHP_METHOD(RocksDBWriteBatch, clear)
+{
+  rocksdb_write_batch_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
+  rocksdb_writebatch_clear(obj->batch);
+  obj->expiry_ambiguous = 0;
+
+  RETURN_TRUE;
+}
+
+/* ------------------- RocksDBIterator Methods ------------------- */
+
+/* public function __construct(RocksDB $db, ?string $prefix = null, ?string $start = null, ?string $end = null, ?RocksDBSnapshot $snapshot = null, ?RocksDBColumnFamily $columnFamily = null) */
+PHP_METHOD(RocksDBIterator, __construct)
+{
+  zval *db_zv;
+  char *prefix = NULL, *start = NULL, *end = NULL;
+  size_t prefix_len = 0, start_len = 0, end_len = 0;
+  zval *snapshot_zv = NULL, *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_snapshot_object *snap_obj = NULL;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_iterator_object *it_obj;
+  rocksdb_object *db_obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O|s!s!s!O!O!a!", &db_zv, php_rocksdb_ce,
+      &prefix, &prefix_len, &start, &start_len, &end, &end_len,
+      &snapshot_zv, php_rocksdb_snapshot_ce,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  it_obj = php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
+  db_obj = php_rocksdb_object_from_zobj(Z_OBJ_P(db_zv));
+  if (snapshot_zv && !(snap_obj = php_rocksdb_snapshot_from_zval(snapshot_zv, db_obj))) {
+    return;
+  }
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, db_obj))) {
+    return;
+  }
+
+  php_rocksdb_iterator_init(it_obj, db_obj, prefix, prefix_len,
+    start, start_len, end, end_len, snap_obj, cf_obj, read_options_zv);
+}
+
+#define ROCKSDB_ITERATOR_FETCH(it_obj) \
+  (it_obj) = php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis())); \
+  if (!php_rocksdb_iterator_usable(it_obj)) { \
+    return; \
+  }
+
+/* public function valid(): bool */
+PHP_METHOD(RocksDBIterator, valid)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  RETURN_BOOL(php_rocksdb_iterator_in_range(it_obj));
+}
+
+/* public function key(): string */
+PHP_METHOD(RocksDBIterator, key)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  /* Also steps over expired entries */
+  if (!php_rocksdb_iterator_in_range(it_obj)) {
+    RETURN_FALSE;
+  }
+  size_t key_len;
+  const char *key = rocksdb_iter_key(it_obj->iter, &key_len);
+  RETVAL_STRINGL(key, key_len);
+}
+
+/* public function current(): string */
+PHP_METHOD(RocksDBIterator, current)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (!php_rocksdb_iterator_in_range(it_obj)) {
+    RETURN_FALSE;
+  }
+  php_rocksdb_iterator_value(it_obj, return_value, it_obj->decode_values);
+}
+
+/* public function next(): void */
+PHP_METHOD(RocksDBIterator, next)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (it_obj->iter && rocksdb_iter_valid(it_obj->iter)) {
+    it_obj->backward = 0;
+    rocksdb_iter_next(it_obj->iter);
+  }
+}
+
+/* public function rewind(): void */
+PHP_METHOD(RocksDBIterator, rewind)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  php_rocksdb_iterator_rewind(it_obj);
+}
+
+/* public function prev(): void */
+PHP_METHOD(RocksDBIterator, prev)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (it_obj->iter && rocksdb_iter_valid(it_obj->iter)) {
+    php_rocksdb_iterator_total_order(it_obj);
+    it_obj->backward = 1;
+    rocksdb_iter_prev(it_obj->iter);
+  }
+}
+
+/* public function seek(string $key): void
+   Positions on the first key >= $key (clamped to the iterator's range). */
+PHP_METHOD(RocksDBIterator, seek)
+{
+  char *key;
+  size_t key_len;
+  rocksdb_iterator_object *it_obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
+    return;
+  }
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (it_obj->iter) {
+    it_obj->backward = 0;
+    rocksdb_iter_seek(it_obj->iter, key, key_len);
+  }
+}
+
+/* public function seekForPrev(string $key): void
+   Positions on the last key <= $key (clamped to the iterator's range). */
+PHP_METHOD(RocksDBIterator, seekForPrev)
+{
+  char *key;
+  size_t key_len;
+  rocksdb_iterator_object *it_obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
+    return;
+  }
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (it_obj->iter) {
+    php_rocksdb_iterator_total_order(it_obj);
+    it_obj->backward = 1;
+    rocksdb_iter_seek_for_prev(it_obj->iter, key, key_len);
+  }
+}
+
+/* public function seekToFirst(): void */
+PHP_METHOD(RocksDBIterator, seekToFirst)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  php_rocksdb_iterator_rewind(it_obj);
+}
+
+/* public function seekToLast(): void */
+PHP_METHOD(RocksDBIterator, seekToLast)
+{
+  rocksdb_iterator_object *it_obj;
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (it_obj->iter) {
+    php_rocksdb_iterator_total_order(it_obj);
+    it_obj->backward = 1;
+    rocksdb_iter_seek_to_last(it_obj->iter);
+  }
+}
+
+/* public function fetch(int $n, int $mode = RocksDBIterator::KEYS_AND_VALUES): array
+   Reads up to $n entries from the current position and leaves the iterator
+   on the entry after the last one returned. RocksDBIterator::DECODE_VALUES
+   in $mode (or decodeValues()) returns putValue() values decoded. */
+PHP_METHOD(RocksDBIterator, fetch)
+{
+  zend_long n, mode = PHP_ROCKSDB_FETCH_KEYS_AND_VALUES;
+  rocksdb_iterator_object *it_obj;
+  const char *key;
+  size_t key_len;
+  zend_bool decode;
+  zval val;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l|l", &n, &mode) == FAILURE) {
+    return;
+  }
+  ROCKSDB_ITERATOR_FETCH(it_obj);
+  if (!it_obj->iter) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Iterator has been destroyed", 0);
+    return;
+  }
+  if (n <= 0) {
+    RETURN_EMPTY_ARRAY();
+  }
+  decode = (mode & PHP_ROCKSDB_FETCH_DECODE_VALUES) || it_obj->decode_values;
+  mode &= ~PHP_ROCKSDB_FETCH_DECODE_VALUES;
+
+  array_init_size(return_value, n < 1024 ? (uint32_t)n : 1024);
+  while (n-- > 0 && php_rocksdb_iterator_in_range(it_obj)) {
+    if (mode != PHP_ROCKSDB_FETCH_KEYS_ONLY
+        && php_rocksdb_iterator_value(it_obj, &val, decode) == FAILURE) {
+      zval_ptr_dtor(return_value);
+      ZVAL_UNDEF(return_value);
+      return;
+    }
+    switch (mode) {
+      case PHP_ROCKSDB_FETCH_KEYS_ONLY:
+        key = rocksdb_iter_key(it_obj->iter, &key_len);
+        add_next_index_stringl(return_value, key, key_len);
+        break;
+      case PHP_ROCKSDB_FETCH_VALUES_ONLY:
+        add_next_index_zval(return_value, &val);
+        break;
+      default:
+        key = rocksdb_iter_key(it_obj->iter, &key_len);
+        add_assoc_zval_ex(return_value, key, key_len, &val);
+        break;
+    }
+    rocksdb_iter_next(it_obj->iter);
   }
+}
 
-  efree(c_keys);
-  efree(c_key_lens);
-  efree(c_vals);
-  efree(c_val_lens);
-  efree(c_errs);
+/* public function decodeValues(bool $decode = true): void
+   Makes current(), foreach and fetch() decode putValue() values. */
+PHP_METHOD(RocksDBIterator, decodeValues)
+{
+  zend_bool decode = 1;
+  rocksdb_iterator_object *it_obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|b", &decode) == FAILURE) {
+    return;
+  }
+  it_obj = php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
+  it_obj->decode_values = decode;
 }
 
-/* public function RocksDB::put(string $key, string $value): bool */
-PHP_METHOD(RocksDB, put)
+/* public function destroy(): bool */
+PHP_METHOD(RocksDBIterator, destroy)
 {
-  char *key, *value;
+  rocksdb_iterator_object *it_obj =
+    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
+  if (it_obj->iter) {
+    rocksdb_iter_destroy(it_obj->iter);
+    it_obj->iter = NULL;
+  }
+  RETURN_TRUE;
+}
+
+/* ------------------- RocksDBCache Methods ------------------- */
+
+#define ROCKSDB_CACHE_FETCH(obj) \
+  (obj) = php_rocksdb_cache_object_from_zobj(Z_OBJ_P(getThis())); \
+  if (!(obj)->cache) { \
+    zend_throw_exception(php_rocksdb_exception_ce, "RocksDBCache is not initialized", 0); \
+    return; \
+  }
+
+/* public function __construct(int $capacity, bool $strictCapacityLimit = false) */
+PHP_METHOD(RocksDBCache, __construct)
+{
+  zend_long capacity;
+  zend_bool strict = 0;
+  rocksdb_cache_object *obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l|b", &capacity, &strict) == FAILURE) {
+    return;
+  }
+  if (capacity < 0) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Cache capacity must not be negative", 0);
+    return;
+  }
+  obj = php_rocksdb_cache_object_from_zobj(Z_OBJ_P(getThis()));
+  php_rocksdb_cache_release(obj->cache);
+  obj->cache = php_rocksdb_cache_create((size_t)capacity, strict);
+}
+
+/* public function getCapacity(): int */
+PHP_METHOD(RocksDBCache, getCapacity)
+{
+  rocksdb_cache_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_CACHE_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_cache_get_capacity(obj->cache->cache));
+}
+
+/* public function setCapacity(int $capacity): bool */
+PHP_METHOD(RocksDBCache, setCapacity)
+{
+  zend_long capacity;
+  rocksdb_cache_object *obj;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &capacity) == FAILURE) {
+    return;
+  }
+  ROCKSDB_CACHE_FETCH(obj);
+  if (capacity < 0) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Cache capacity must not be negative", 0);
+    return;
+  }
+  rocksdb_cache_set_capacity(obj->cache->cache, (size_t)capacity);
+  RETURN_TRUE;
+}
+
+/* public function getUsage(): int */
+PHP_METHOD(RocksDBCache, getUsage)
+{
+  rocksdb_cache_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_CACHE_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_cache_get_usage(obj->cache->cache));
+}
+
+/* public function getPinnedUsage(): int */
+PHP_METHOD(RocksDBCache, getPinnedUsage)
+{
+  rocksdb_cache_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_CACHE_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_cache_get_pinned_usage(obj->cache->cache));
+}
+
+/* ------------------- RocksDBTransaction Methods ------------------- */
+
+#define ROCKSDB_TRANSACTION_FETCH(obj) \
+  (obj) = php_rocksdb_transaction_object_from_zobj(Z_OBJ_P(getThis())); \
+  if (!(obj)->txn) { \
+    zend_throw_exception(php_rocksdb_exception_ce, \
+      "RocksDBTransaction is not initialized, use RocksDB::beginTransaction()", 0); \
+    return; \
+  } \
+  if ((obj)->finished) { \
+    zend_throw_exception(php_rocksdb_exception_ce, \
+      "Transaction is already committed or rolled back", 0); \
+    return; \
+  }
+
+/* Destroys the engine iterators reading the transaction's write batch before
+   the batch is cleared or truncated; the PHP iterators throw from then on.
+   Done before the call, as an engine error may leave the batch changed. */
+static void php_rocksdb_transaction_invalidate_iterators(rocksdb_transaction_object *txn_obj) {
+  rocksdb_iterator_object *it_obj;
+
+  ZEND_HASH_FOREACH_PTR(&txn_obj->iterators, it_obj) {
+    if (it_obj->iter) {
+      rocksdb_iter_destroy(it_obj->iter);
+      it_obj->iter = NULL;
+    }
+    it_obj->invalidated = 1;
+  } ZEND_HASH_FOREACH_END();
+  zend_hash_clean(&txn_obj->iterators);
+}
+
+/* Point read inside the transaction: sees its own writes and, with
+   'set_snapshot', reads as of begin. for_update also locks (pessimistic) or
+   tracks (optimistic) the key for conflict detection. */
+static rocksdb_pinnableslice_t *php_rocksdb_transaction_get_pinned(
+    rocksdb_transaction_object *txn_obj, rocksdb_readoptions_t *ro,
+    rocksdb_column_family_object *cf_obj, const char *key, size_t key_len,
+    zend_bool for_update, zend_bool exclusive, char **err) {
+  rocksdb_pinnableslice_t *slice;
+
+  if (txn_obj->snapshot) {
+    rocksdb_readoptions_set_snapshot(ro, txn_obj->snapshot);
+  }
+  if (for_update) {
+    slice = cf_obj
+      ? rocksdb_transaction_get_pinned_for_update_cf(txn_obj->txn, ro, cf_obj->cf->handle,
+          key, key_len, exclusive, err)
+      : rocksdb_transaction_get_pinned_for_update(txn_obj->txn, ro, key, key_len, exclusive, err);
+  } else {
+    slice = cf_obj
+      ? rocksdb_transaction_get_pinned_cf(txn_obj->txn, ro, cf_obj->cf->handle, key, key_len, err)
+      : rocksdb_transaction_get_pinned(txn_obj->txn, ro, key, key_len, err);
+  }
+  if (txn_obj->snapshot) {
+    rocksdb_readoptions_set_snapshot(ro, NULL);
+  }
+  return slice;
+}
+
+/* public function get(string $key, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): ?string */
+PHP_METHOD(RocksDBTransaction, get)
+{
+  char *key, *err = NULL;
+  const char *val;
+  size_t key_len, val_len;
+  zval *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_pinnableslice_t *slice;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!a!", &key, &key_len,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
+    return;
+  }
+
+  slice = php_rocksdb_transaction_get_pinned(obj,
+    php_rocksdb_call_read_options(obj->db_obj, read_options_zv),
+    cf_obj, key, key_len, 0, 0, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  if (!php_rocksdb_pinned_value(obj->db_obj, &slice, &val, &val_len)) {
+    RETURN_NULL();
+  }
+  RETVAL_STRINGL(val, val_len);
+  rocksdb_pinnableslice_destroy(slice);
+}
+
+/* public function getForUpdate(string $key, ?RocksDBColumnFamily $columnFamily = null, bool $exclusive = true, ?array $readOptions = null): ?string
+   Reads the key and locks it until commit/rollback (pessimistic; throws on
+   lock timeout or deadlock) or makes commit fail if it changes meanwhile
+   (optimistic) */
+PHP_METHOD(RocksDBTransaction, getForUpdate)
+{
+  char *key, *err = NULL;
+  const char *val;
+  size_t key_len, val_len;
+  zval *cf_zv = NULL, *read_options_zv = NULL;
+  zend_bool exclusive = 1;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+  rocksdb_pinnableslice_t *slice;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!ba!", &key, &key_len,
+      &cf_zv, php_rocksdb_column_family_ce, &exclusive, &read_options_zv) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
+    return;
+  }
+
+  slice = php_rocksdb_transaction_get_pinned(obj,
+    php_rocksdb_call_read_options(obj->db_obj, read_options_zv),
+    cf_obj, key, key_len, 1, exclusive, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  if (!php_rocksdb_pinned_value(obj->db_obj, &slice, &val, &val_len)) {
+    RETURN_NULL();
+  }
+  RETVAL_STRINGL(val, val_len);
+  rocksdb_pinnableslice_destroy(slice);
+}
+
+/* public function put(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool */
+PHP_METHOD(RocksDBTransaction, put)
+{
+  char *key, *value, *err = NULL, *framed = NULL;
   size_t key_len, value_len;
-  char *err = NULL;
-  rocksdb_object *obj;
+  zval *cf_zv = NULL;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss", &key, &key_len, &value, &value_len) == FAILURE) {
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!", &key, &key_len, &value, &value_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
     return;
   }
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
 
-  rocksdb_put(obj->db, obj->write_options, key, key_len, value, value_len, &err);
+  if (obj->db_obj->expiry_filter) {
+    framed = php_rocksdb_expiry_frame(value, value_len, 0, &value_len);
+    value = framed;
+  }
+  if (cf_obj) {
+    rocksdb_transaction_put_cf(obj->txn, cf_obj->cf->handle, key, key_len, value, value_len, &err);
+  } else {
+    rocksdb_transaction_put(obj->txn, key, key_len, value, value_len, &err);
+  }
+  if (framed) {
+    efree(framed);
+  }
   ROCKSDB_CHECK_ERROR(err);
 
   RETURN_TRUE;
 }
 
-/* public function RocksDB::delete(string $key): bool */
-PHP_METHOD(RocksDB, delete)
+/* public function merge(string $key, string $value, ?RocksDBColumnFamily $columnFamily = null): bool */
+PHP_METHOD(RocksDBTransaction, merge)
 {
-  char *key;
+  char *key, *value, *err = NULL;
+  size_t key_len, value_len;
+  zval *cf_zv = NULL;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss|O!", &key, &key_len, &value, &value_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
+    return;
+  }
+  if (php_rocksdb_expiry_reject(obj->db_obj, value, value_len)) {
+    return;
+  }
+
+  if (cf_obj) {
+    rocksdb_transaction_merge_cf(obj->txn, cf_obj->cf->handle, key, key_len, value, value_len, &err);
+  } else {
+    rocksdb_transaction_merge(obj->txn, key, key_len, value, value_len, &err);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function delete(string $key, ?RocksDBColumnFamily $columnFamily = null): bool */
+PHP_METHOD(RocksDBTransaction, delete)
+{
+  char *key, *err = NULL;
   size_t key_len;
+  zval *cf_zv = NULL;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!", &key, &key_len,
+      &cf_zv, php_rocksdb_column_family_ce) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
+    return;
+  }
+
+  if (cf_obj) {
+    rocksdb_transaction_delete_cf(obj->txn, cf_obj->cf->handle, key, key_len, &err);
+  } else {
+    rocksdb_transaction_delete(obj->txn, key, key_len, &err);
+  }
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
+}
+
+/* public function commit(): bool
+   Throws on a write conflict (optimistic) or an expired transaction; the
+   transaction can then still be rolled back */
+PHP_METHOD(RocksDBTransaction, commit)
+{
   char *err = NULL;
-  rocksdb_object *obj;
+  rocksdb_transaction_object *obj;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
+  if (zend_parse_parameters_none() == FAILURE) {
     return;
   }
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
+  ROCKSDB_TRANSACTION_FETCH(obj);
+
+  php_rocksdb_transaction_invalidate_iterators(obj);
+  rocksdb_transaction_commit(obj->txn, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  obj->finished = 1;
+  RETURN_TRUE;
+}
+
+/* public function rollback(): bool */
+PHP_METHOD(RocksDBTransaction, rollback)
+{
+  char *err = NULL;
+  rocksdb_transaction_object *obj;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+
+  php_rocksdb_transaction_invalidate_iterators(obj);
+  rocksdb_transaction_rollback(obj->txn, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  obj->finished = 1;
+  RETURN_TRUE;
+}
+
+/* public function setSavePoint(): bool */
+PHP_METHOD(RocksDBTransaction, setSavePoint)
+{
+  rocksdb_transaction_object *obj;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+
+  rocksdb_transaction_set_savepoint(obj->txn);
+  RETURN_TRUE;
+}
+
+/* public function rollbackToSavePoint(): bool
+   Undoes the writes since the last setSavePoint() and pops it; throws when
+   there is none */
+PHP_METHOD(RocksDBTransaction, rollbackToSavePoint)
+{
+  char *err = NULL;
+  rocksdb_transaction_object *obj;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
 
-  rocksdb_delete(obj->db, obj->write_options, key, key_len, &err);
+  php_rocksdb_transaction_invalidate_iterators(obj);
+  rocksdb_transaction_rollback_to_savepoint(obj->txn, &err);
   ROCKSDB_CHECK_ERROR(err);
 
   RETURN_TRUE;
 }
 
-/* public function RocksDB::write(RocksDBWriteBatch $batch, array $writeOptions = null): bool */
-PHP_METHOD(RocksDB, write)
+static void php_rocksdb_transaction_iterator(zval *return_value, rocksdb_transaction_object *obj,
+    const char *prefix, size_t prefix_len, rocksdb_column_family_object *cf_obj,
+    zval *read_options_zv) {
+  rocksdb_iterator_object *it_obj;
+
+  object_init_ex(return_value, php_rocksdb_iterator_ce);
+  it_obj = php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(return_value));
+  it_obj->txn_obj = obj;
+  GC_ADDREF(&obj->std);
+  php_rocksdb_iterator_init(it_obj, obj->db_obj,
+    prefix, prefix_len, NULL, 0, NULL, 0, NULL, cf_obj, read_options_zv);
+  zend_hash_index_add_ptr(&obj->iterators, it_obj->std.handle, it_obj);
+}
+
+/* public function getIterator(?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator
+   Sees the transaction's uncommitted writes over the DB */
+PHP_METHOD(RocksDBTransaction, getIterator)
+{
+  zval *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|O!a!",
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
+    return;
+  }
+
+  php_rocksdb_transaction_iterator(return_value, obj, NULL, 0, cf_obj, read_options_zv);
+}
+
+/* public function prefixSearch(string $prefix, ?RocksDBColumnFamily $columnFamily = null, ?array $readOptions = null): RocksDBIterator */
+PHP_METHOD(RocksDBTransaction, prefixSearch)
+{
+  char *prefix;
+  size_t prefix_len;
+  zval *cf_zv = NULL, *read_options_zv = NULL;
+  rocksdb_transaction_object *obj;
+  rocksdb_column_family_object *cf_obj = NULL;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s|O!a!", &prefix, &prefix_len,
+      &cf_zv, php_rocksdb_column_family_ce, &read_options_zv) == FAILURE) {
+    return;
+  }
+  ROCKSDB_TRANSACTION_FETCH(obj);
+  if (cf_zv && !(cf_obj = php_rocksdb_column_family_from_zval(cf_zv, obj->db_obj))) {
+    return;
+  }
+
+  php_rocksdb_transaction_iterator(return_value, obj, prefix, prefix_len, cf_obj, read_options_zv);
+}
+
+/* ------------------- RocksDBWriteBufferManager Methods ------------------- */
+
+#define ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj) \
+  (obj) = php_rocksdb_write_buffer_manager_object_from_zobj(Z_OBJ_P(getThis())); \
+  if (!(obj)->wbm) { \
+    zend_throw_exception(php_rocksdb_exception_ce, "RocksDBWriteBufferManager is not initialized", 0); \
+    return; \
+  }
+
+/* public function __construct(int $bufferSize, ?RocksDBCache $cache = null, bool $allowStall = false)
+   Caps the memtable memory of every DB opened with it at $bufferSize; with
+   $cache the memtables are also charged to that block cache */
+PHP_METHOD(RocksDBWriteBufferManager, __construct)
+{
+  zend_long buffer_size;
+  zval *cache_zv = NULL;
+  zend_bool allow_stall = 0;
+  rocksdb_write_buffer_manager_object *obj;
+  rocksdb_cache_object *cache_obj = NULL;
+  php_rocksdb_write_buffer_manager *m;
+  smart_str sig = {0}, key = {0};
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l|O!b", &buffer_size,
+      &cache_zv, php_rocksdb_cache_ce, &allow_stall) == FAILURE) {
+    return;
+  }
+  if (buffer_size < 0) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Buffer size must not be negative", 0);
+    return;
+  }
+  if (cache_zv) {
+    cache_obj = php_rocksdb_cache_object_from_zobj(Z_OBJ_P(cache_zv));
+    if (!cache_obj->cache) {
+      zend_throw_exception(php_rocksdb_exception_ce, "RocksDBCache is not initialized", 0);
+      return;
+    }
+  }
+  obj = php_rocksdb_write_buffer_manager_object_from_zobj(Z_OBJ_P(getThis()));
+  php_rocksdb_write_buffer_manager_release(obj->wbm);
+  obj->wbm = NULL;
+
+  smart_str_appendc(&sig, '(');
+  smart_str_append_long(&sig, buffer_size);
+  smart_str_appendc(&sig, ',');
+  smart_str_appendc(&sig, allow_stall ? '1' : '0');
+  if (cache_obj) {
+    smart_str_appendc(&sig, ',');
+    php_rocksdb_cache_signature(&sig, cache_obj->cache);
+  }
+  smart_str_appendc(&sig, ')');
+  smart_str_0(&sig);
+  /* Charged to a cache, the manager is only shared with managers built on
+     that same cache */
+  smart_str_append(&key, sig.s);
+  if (cache_obj) {
+    smart_str_appendc(&key, '@');
+    smart_str_append_unsigned(&key, (zend_ulong)(uintptr_t)cache_obj->cache);
+  }
+  smart_str_0(&key);
+
+  m = zend_hash_find_ptr(&ROCKSDB_G(write_buffer_managers), key.s);
+  if (m) {
+    m->refcount++;
+  } else {
+    m = pemalloc(sizeof(php_rocksdb_write_buffer_manager), 1);
+    m->wbm = cache_obj
+      ? rocksdb_write_buffer_manager_create_with_cache((size_t)buffer_size,
+          cache_obj->cache->cache, allow_stall)
+      : rocksdb_write_buffer_manager_create((size_t)buffer_size, allow_stall);
+    m->cache = cache_obj ? cache_obj->cache : NULL;
+    if (m->cache) {
+      m->cache->refcount++;
+    }
+    m->registry = &ROCKSDB_G(write_buffer_managers);
+    m->key = zend_string_init(ZSTR_VAL(key.s), ZSTR_LEN(key.s), 1);
+    m->signature = zend_string_init(ZSTR_VAL(sig.s), ZSTR_LEN(sig.s), 1);
+    m->refcount = 1;
+    zend_hash_add_ptr(m->registry, m->key, m);
+  }
+  obj->wbm = m;
+  smart_str_free(&sig);
+  smart_str_free(&key);
+}
+
+/* public function getBufferSize(): int */
+PHP_METHOD(RocksDBWriteBufferManager, getBufferSize)
+{
+  rocksdb_write_buffer_manager_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_write_buffer_manager_buffer_size(obj->wbm->wbm));
+}
+
+/* public function setBufferSize(int $bufferSize): bool */
+PHP_METHOD(RocksDBWriteBufferManager, setBufferSize)
+{
+  zend_long buffer_size;
+  rocksdb_write_buffer_manager_object *obj;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &buffer_size) == FAILURE) {
+    return;
+  }
+  ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj);
+  if (buffer_size < 0) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Buffer size must not be negative", 0);
+    return;
+  }
+  rocksdb_write_buffer_manager_set_buffer_size(obj->wbm->wbm, (size_t)buffer_size);
+  RETURN_TRUE;
+}
+
+/* public function setAllowStall(bool $allowStall): bool */
+PHP_METHOD(RocksDBWriteBufferManager, setAllowStall)
+{
+  zend_bool allow_stall;
+  rocksdb_write_buffer_manager_object *obj;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "b", &allow_stall) == FAILURE) {
+    return;
+  }
+  ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj);
+  rocksdb_write_buffer_manager_set_allow_stall(obj->wbm->wbm, allow_stall);
+  RETURN_TRUE;
+}
+
+/* public function getMemoryUsage(): int */
+PHP_METHOD(RocksDBWriteBufferManager, getMemoryUsage)
 {
-  zval *batch_zv;
-  zval *writeoptions_zv = NULL;
-  char *err = NULL;
-  rocksdb_object *obj;
-  rocksdb_write_batch_object *batch_obj;
-
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O|a!",
-      &batch_zv, php_rocksdb_write_batch_ce, &writeoptions_zv) == FAILURE) {
+  rocksdb_write_buffer_manager_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
     return;
   }
+  ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_write_buffer_manager_memory_usage(obj->wbm->wbm));
+}
 
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
-  batch_obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(batch_zv));
+/* public function getMutableMemoryUsage(): int */
+PHP_METHOD(RocksDBWriteBufferManager, getMutableMemoryUsage)
+{
+  rocksdb_write_buffer_manager_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_write_buffer_manager_mutable_memtable_memory_usage(obj->wbm->wbm));
+}
 
-  rocksdb_writeoptions_t *wo = rocksdb_writeoptions_create();
+/* public function getCacheUsage(): int
+   Bytes reserved in the block cache on behalf of memtables (0 without a cache) */
+PHP_METHOD(RocksDBWriteBufferManager, getCacheUsage)
+{
+  rocksdb_write_buffer_manager_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  ROCKSDB_WRITE_BUFFER_MANAGER_FETCH(obj);
+  RETURN_LONG((zend_long)rocksdb_write_buffer_manager_dummy_entries_in_cache_usage(obj->wbm->wbm));
+}
 
-  if (writeoptions_zv && Z_TYPE_P(writeoptions_zv) == IS_ARRAY) {
-    zval *val;
-    HashTable *ht = Z_ARRVAL_P(writeoptions_zv);
+/* ------------------- RocksDBRateLimiter Methods ------------------- */
 
-    if ((val = zend_hash_str_find(ht, "disable_wal", sizeof("disable_wal") - 1)) != NULL) {
-      if (zend_is_true(val)) {
-        rocksdb_writeoptions_disable_WAL(wo, 1);
-      }
-    }
-    if ((val = zend_hash_str_find(ht, "sync", sizeof("sync") - 1)) != NULL) {
-      if (zend_is_true(val)) {
-        rocksdb_writeoptions_set_sync(wo, 1);
-      } else {
-        rocksdb_writeoptions_set_sync(wo, 0);
-      }
-    }
+/* public function __construct(int $bytesPerSecond, bool $autoTuned = false, int $refillPeriodMicros = 100000, int $fairness = 10)
+   Throttles flush and compaction writes of every DB opened with it; when
+   $autoTuned, $bytesPerSecond is the upper bound and the rate adapts to demand */
+PHP_METHOD(RocksDBRateLimiter, __construct)
+{
+  zend_long rate, refill_period = 100000, fairness = 10;
+  zend_bool auto_tuned = 0;
+  rocksdb_rate_limiter_object *obj;
+  php_rocksdb_rate_limiter *l;
+  smart_str sig = {0};
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l|bll", &rate, &auto_tuned,
+      &refill_period, &fairness) == FAILURE) {
+    return;
+  }
+  if (rate <= 0 || refill_period <= 0 || fairness <= 0) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "Rate, refill period and fairness must be positive", 0);
+    return;
+  }
+  obj = php_rocksdb_rate_limiter_object_from_zobj(Z_OBJ_P(getThis()));
+  php_rocksdb_rate_limiter_release(obj->limiter);
+  obj->limiter = NULL;
+
+  smart_str_appendc(&sig, '(');
+  smart_str_append_long(&sig, rate);
+  smart_str_appendc(&sig, ',');
+  smart_str_appendc(&sig, auto_tuned ? '1' : '0');
+  smart_str_appendc(&sig, ',');
+  smart_str_append_long(&sig, refill_period);
+  smart_str_appendc(&sig, ',');
+  smart_str_append_long(&sig, fairness);
+  smart_str_appendc(&sig, ')');
+  smart_str_0(&sig);
+
+  l = zend_hash_find_ptr(&ROCKSDB_G(rate_limiters), sig.s);
+  if (l) {
+    l->refcount++;
+  } else {
+    l = pemalloc(sizeof(php_rocksdb_rate_limiter), 1);
+    l->limiter = auto_tuned
+      ? rocksdb_ratelimiter_create_auto_tuned(rate, refill_period, (int32_t)fairness)
+      : rocksdb_ratelimiter_create(rate, refill_period, (int32_t)fairness);
+    l->registry = &ROCKSDB_G(rate_limiters);
+    l->signature = zend_string_init(ZSTR_VAL(sig.s), ZSTR_LEN(sig.s), 1);
+    l->refcount = 1;
+    zend_hash_add_ptr(l->registry, l->signature, l);
   }
+  obj->limiter = l;
+  smart_str_free(&sig);
+}
 
-  rocksdb_write(obj->db, wo, batch_obj->batch, &err);
-  rocksdb_writeoptions_destroy(wo);
+/* ------------------- RocksDBSnapshot Methods ------------------- */
 
-  ROCKSDB_CHECK_ERROR(err);
+/* public function __construct(RocksDB $db) */
+PHP_METHOD(RocksDBSnapshot, __construct)
+{
+  zval *db_zv;
+  rocksdb_snapshot_object *obj;
 
-  RETURN_TRUE;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O", &db_zv, php_rocksdb_ce) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_snapshot_object_from_zobj(Z_OBJ_P(getThis()));
+  if (obj->db_obj) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Snapshot is already initialized", 0);
+    return;
+  }
+  php_rocksdb_snapshot_init(obj, php_rocksdb_object_from_zobj(Z_OBJ_P(db_zv)));
 }
 
-/* public function RocksDB::getIterator(): RocksDBIterator */
-PHP_METHOD(RocksDB, getIterator)
+/* public function getSequenceNumber(): int */
+PHP_METHOD(RocksDBSnapshot, getSequenceNumber)
 {
-  object_init_ex(return_value, php_rocksdb_iterator_ce);
-
-  {
-    zval db_obj, fname, retval;
-    zval params[1];
-    ZVAL_COPY_VALUE(&db_obj, getThis());
-    ZVAL_STRING(&fname, "__construct");
-    ZVAL_COPY_VALUE(&params[0], &db_obj);
-
-    call_user_function(NULL, return_value, &fname, &retval, 1, params);
-    zval_dtor(&fname);
-    zval_ptr_dtor(&retval);
+  rocksdb_snapshot_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_snapshot_object_from_zobj(Z_OBJ_P(getThis()));
+  if (!obj->snapshot) {
+    zend_throw_exception(php_rocksdb_exception_ce, "Snapshot has been released", 0);
+    return;
   }
+  RETURN_LONG((zend_long)rocksdb_snapshot_get_sequence_number(obj->snapshot));
 }
 
-/* public function RocksDB::prefixSearch(string $prefix): RocksDBIterator */
-PHP_METHOD(RocksDB, prefixSearch)
+/* public function release(): bool
+   Releases the snapshot now rather than when the object is freed. With
+   iterators still reading from it the release is deferred until the last
+   one is gone and false is returned; either way the snapshot can no longer
+   be passed to new reads. */
+PHP_METHOD(RocksDBSnapshot, release)
 {
-  char *prefix;
-  size_t prefix_len;
-
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &prefix, &prefix_len) == FAILURE) {
+  rocksdb_snapshot_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
     return;
   }
+  obj = php_rocksdb_snapshot_object_from_zobj(Z_OBJ_P(getThis()));
+  if (obj->live_iterators > 0) {
+    obj->release_pending = 1;
+    RETURN_FALSE;
+  }
+  php_rocksdb_snapshot_release(obj);
+  RETURN_TRUE;
+}
 
-  object_init_ex(return_value, php_rocksdb_iterator_ce);
-
-  {
-    zval db_obj, z_prefix, fname, retval;
-    zval params[2];
-    ZVAL_COPY_VALUE(&db_obj, getThis());
-    ZVAL_STRINGL(&z_prefix, prefix, prefix_len);
-
-    ZVAL_STRING(&fname, "__construct");
-    ZVAL_COPY_VALUE(&params[0], &db_obj);
-    ZVAL_COPY_VALUE(&params[1], &z_prefix);
-
-    call_user_function(NULL, return_value, &fname, &retval, 2, params);
+/* ------------------- RocksDBSstFileWriter Methods ------------------- */
 
-    zval_dtor(&fname);
-    zval_ptr_dtor(&retval);
-    zval_dtor(&z_prefix);
+#define ROCKSDB_SST_FILE_WRITER_FETCH(obj) \
+  (obj) = php_rocksdb_sst_file_writer_object_from_zobj(Z_OBJ_P(getThis())); \
+  if (!(obj)->writer) { \
+    zend_throw_exception(php_rocksdb_exception_ce, "RocksDBSstFileWriter is not initialized", 0); \
+    return; \
   }
-}
 
-/* public function RocksDB::getProperty(string $name): string|null */
-PHP_METHOD(RocksDB, getProperty)
+/* public function __construct(?array $options = null)
+   Takes the same table options (compression, block_size, bloom_bits_per_key,
+   prefix_extractor, ...) as the DB or column family the file is meant for. */
+PHP_METHOD(RocksDBSstFileWriter, __construct)
 {
-  char *name;
-  size_t name_len;
-  rocksdb_object *obj;
-  char *val;
+  zval *options_zv = NULL;
+  rocksdb_sst_file_writer_object *obj;
+  int prefix_extractor = PHP_ROCKSDB_PREFIX_NONE;
+  size_t prefix_extractor_len = 0;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &name, &name_len) == FAILURE) {
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|a!", &options_zv) == FAILURE) {
+    return;
+  }
+  obj = php_rocksdb_sst_file_writer_object_from_zobj(Z_OBJ_P(getThis()));
+  if (obj->writer) {
+    zend_throw_exception(php_rocksdb_exception_ce, "RocksDBSstFileWriter is already initialized", 0);
     return;
   }
-  obj = php_rocksdb_object_from_zobj(Z_OBJ_P(getThis()));
 
-  val = rocksdb_property_value(obj->db, name);
-  if (!val) {
-    RETURN_NULL();
+  obj->options = rocksdb_options_create();
+  if (!php_rocksdb_options_apply(obj->options, options_zv ? Z_ARRVAL_P(options_zv) : NULL,
+      NULL, &prefix_extractor, &prefix_extractor_len)) {
+    return;
   }
-  RETVAL_STRING(val);
-  rocksdb_free(val);
+  obj->env_options = rocksdb_envoptions_create();
+  obj->writer = rocksdb_sstfilewriter_create(obj->env_options, obj->options);
 }
 
-/* ------------------- RocksDBWriteBatch Methods ------------------- */
-
-/* public function __construct() */
-PHP_METHOD(RocksDBWriteBatch, __construct)
+/* public function open(string $path): bool */
+PHP_METHOD(RocksDBSstFileWriter, open)
 {
-  rocksdb_write_batch_object *obj;
-  if (zend_parse_parameters_none() == FAILURE) {
+  char *path;
+  size_t path_len;
+  char *err = NULL;
+  rocksdb_sst_file_writer_object *obj;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "p", &path, &path_len) == FAILURE) {
     return;
   }
-  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
-  obj->batch = rocksdb_writebatch_create();
+  ROCKSDB_SST_FILE_WRITER_FETCH(obj);
+
+  rocksdb_sstfilewriter_open(obj->writer, path, &err);
+  ROCKSDB_CHECK_ERROR(err);
+
+  RETURN_TRUE;
 }
 
-/* public function put(string $key, string $value): bool */
-PHP_METHOD(RocksDBWriteBatch, put)
+/* public function put(string $key, string $value): bool
+   Keys must be added in strictly increasing order. */
+PHP_METHOD(RocksDBSstFileWriter, put)
 {
   char *key, *value;
   size_t key_len, value_len;
-  rocksdb_write_batch_object *obj;
+  char *err = NULL;
+  rocksdb_sst_file_writer_object *obj;
 
   if (zend_parse_parameters(ZEND_NUM_ARGS(), "ss",
       &key, &key_len, &value, &value_len) == FAILURE) {
     return;
   }
-  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
-  rocksdb_writebatch_put(obj->batch, key, key_len, value, value_len);
+  ROCKSDB_SST_FILE_WRITER_FETCH(obj);
+
+  rocksdb_sstfilewriter_put(obj->writer, key, key_len, value, value_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
 
   RETURN_TRUE;
 }
 
 /* public function delete(string $key): bool */
-PHP_METHOD(RocksDBWriteBatch, delete)
+PHP_METHOD(RocksDBSstFileWriter, delete)
 {
   char *key;
   size_t key_len;
-  rocksdb_write_batch_object *obj;
+  char *err = NULL;
+  rocksdb_sst_file_writer_object *obj;
 
   if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
     return;
   }
-  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
-  rocksdb_writebatch_delete(obj->batch, key, key_len);
-
-  RETURN_TRUE;
-}
+  ROCKSDB_SST_FILE_WRITER_FETCH(obj);
 
-/* public function clear(): bool */
-PHP_METHOD(RocksDBWriteBatch, clear)
-{
-  rocksdb_write_batch_object *obj;
-  if (zend_parse_parameters_none() == FAILURE) {
-    return;
-  }
-  obj = php_rocksdb_write_batch_object_from_zobj(Z_OBJ_P(getThis()));
-  rocksdb_writebatch_clear(obj->batch);
+  rocksdb_sstfilewriter_delete(obj->writer, key, key_len, &err);
+  ROCKSDB_CHECK_ERROR(err);
 
   RETURN_TRUE;
 }
 
-/* ------------------- RocksDBIterator Methods ------------------- */
-
-/* public function __construct(RocksDB $db, string $prefix = null) */
-PHP_METHOD(RocksDBIterator, __construct)
+/* public function finish(): bool
+   Seals the file; the writer can then open() the next one. */
+PHP_METHOD(RocksDBSstFileWriter, finish)
 {
-  zval *db_zv;
-  zval *prefix_zv = NULL;
-  rocksdb_iterator_object *it_obj;
-  rocksdb_object *db_obj;
+  char *err = NULL;
+  rocksdb_sst_file_writer_object *obj;
 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O|z", &db_zv, php_rocksdb_ce, &prefix_zv) == FAILURE) {
+  if (zend_parse_parameters_none() == FAILURE) {
     return;
   }
-  it_obj = php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  db_obj = php_rocksdb_object_from_zobj(Z_OBJ_P(db_zv));
+  ROCKSDB_SST_FILE_WRITER_FETCH(obj);
 
-  it_obj->db_obj = db_obj;
-  it_obj->iter = rocksdb_create_iterator(db_obj->db, db_obj->read_options);
-
-  if (prefix_zv && Z_TYPE_P(prefix_zv) == IS_STRING) {
-    it_obj->prefix_len = Z_STRLEN_P(prefix_zv);
-    it_obj->prefix = estrndup(Z_STRVAL_P(prefix_zv), it_obj->prefix_len);
-    rocksdb_iter_seek(it_obj->iter, it_obj->prefix, it_obj->prefix_len);
-  } else {
-    it_obj->prefix = NULL;
-    it_obj->prefix_len = 0;
-    rocksdb_iter_seek_to_first(it_obj->iter);
-  }
-}
+  rocksdb_sstfilewriter_finish(obj->writer, &err);
+  ROCKSDB_CHECK_ERROR(err);
 
-/* public function valid(): bool */
-PHP_METHOD(RocksDBIterator, valid)
-{
-  rocksdb_iterator_object *it_obj =
-    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  if (!rocksdb_iter_valid(it_obj->iter)) {
-    RETURN_FALSE;
-  }
-  if (it_obj->prefix && it_obj->prefix_len > 0) {
-    size_t key_len;
-    const char *key = rocksdb_iter_key(it_obj->iter, &key_len);
-    if (key_len < it_obj->prefix_len ||
-        memcmp(key, it_obj->prefix, it_obj->prefix_len) != 0) {
-      RETURN_FALSE;
-    }
-  }
   RETURN_TRUE;
 }
 
-/* public function key(): string */
-PHP_METHOD(RocksDBIterator, key)
+/* public function getFileSize(): int */
+PHP_METHOD(RocksDBSstFileWriter, getFileSize)
 {
-  rocksdb_iterator_object *it_obj =
-    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  if (!rocksdb_iter_valid(it_obj->iter)) {
-    RETURN_FALSE;
-  }
-  size_t key_len;
-  const char *key = rocksdb_iter_key(it_obj->iter, &key_len);
-  RETVAL_STRINGL(key, key_len);
-}
+  uint64_t size = 0;
+  rocksdb_sst_file_writer_object *obj;
 
-/* public function current(): string */
-PHP_METHOD(RocksDBIterator, current)
-{
-  rocksdb_iterator_object *it_obj =
-    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  if (!rocksdb_iter_valid(it_obj->iter)) {
-    RETURN_FALSE;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
   }
-  size_t val_len;
-  const char *val = rocksdb_iter_value(it_obj->iter, &val_len);
-  RETVAL_STRINGL(val, val_len);
-}
+  ROCKSDB_SST_FILE_WRITER_FETCH(obj);
 
-/* public function next(): void */
-PHP_METHOD(RocksDBIterator, next)
-{
-  rocksdb_iterator_object *it_obj =
-    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  if (rocksdb_iter_valid(it_obj->iter)) {
-    rocksdb_iter_next(it_obj->iter);
-  }
+  rocksdb_sstfilewriter_file_size(obj->writer, &size);
+  RETURN_LONG((zend_long)size);
 }
 
-/* public function rewind(): void */
-PHP_METHOD(RocksDBIterator, rewind)
-{
-  rocksdb_iterator_object *it_obj =
-    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  if (it_obj->prefix && it_obj->prefix_len > 0) {
-    rocksdb_iter_seek(it_obj->iter, it_obj->prefix, it_obj->prefix_len);
-  } else {
-    rocksdb_iter_seek_to_first(it_obj->iter);
-  }
-}
+/* ------------------- RocksDBColumnFamily Methods ------------------- */
 
-/* public function destroy(): bool */
-PHP_METHOD(RocksDBIterator, destroy)
+/* public function getName(): string */
+PHP_METHOD(RocksDBColumnFamily, getName)
 {
-  rocksdb_iterator_object *it_obj =
-    php_rocksdb_iterator_object_from_zobj(Z_OBJ_P(getThis()));
-  if (it_obj->iter) {
-    rocksdb_iter_destroy(it_obj->iter);
-    it_obj->iter = NULL;
+  rocksdb_column_family_object *obj;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
   }
-  RETURN_TRUE;
+  obj = php_rocksdb_column_family_object_from_zobj(Z_OBJ_P(getThis()));
+  if (!obj->cf) {
+    zend_throw_exception(php_rocksdb_exception_ce,
+      "RocksDBColumnFamily must be obtained from RocksDB::getColumnFamily()", 0);
+    return;
+  }
+  RETURN_STRING(obj->cf->name);
 }
 
 /* ------------------- Method Tables ------------------- */
@@ -799,21 +6586,57 @@ PHP_METHOD(RocksDBIterator, destroy)
 static const zend_function_entry rocksdb_methods[] = {
   PHP_ME(RocksDB, __construct,   arginfo_rocksdb___construct,   ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
   PHP_ME(RocksDB, compactRange,  arginfo_rocksdb_compactRange,  ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, tryCatchUpWithPrimary, arginfo_rocksdb_tryCatchUpWithPrimary, ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, get,           arginfo_rocksdb_get,           ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getInto,       arginfo_rocksdb_getInto,       ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getRange,      arginfo_rocksdb_getRange,      ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, multiGet,      arginfo_rocksdb_multiGet,      ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, put,           arginfo_rocksdb_put,           ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, putValue,      arginfo_rocksdb_putValue,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getValue,      arginfo_rocksdb_getValue,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, multiGetValues, arginfo_rocksdb_multiGet,     ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, merge,         arginfo_rocksdb_merge,         ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, delete,        arginfo_rocksdb_delete,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, deleteRange,   arginfo_rocksdb_deleteRange,   ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, deletePrefix,  arginfo_rocksdb_deletePrefix,  ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, deleteFilesInRange, arginfo_rocksdb_deleteFilesInRange, ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, write,         arginfo_rocksdb_write,         ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, getIterator,   arginfo_rocksdb_getIterator,   ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, prefixSearch,  arginfo_rocksdb_prefixSearch,  ZEND_ACC_PUBLIC)
   PHP_ME(RocksDB, getProperty,   arginfo_rocksdb_getProperty,   ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getCacheStats, arginfo_rocksdb_getCacheStats, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getIntProperty, arginfo_rocksdb_getTypedProperty, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getMapProperty, arginfo_rocksdb_getTypedProperty, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getEstimatedNumKeys, arginfo_rocksdb_getSizeProperty, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getEstimatedLiveDataSize, arginfo_rocksdb_getSizeProperty, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getTotalSstFilesSize, arginfo_rocksdb_getSizeProperty, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getLevelStats, arginfo_rocksdb_getSizeProperty, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, approximateSizes, arginfo_rocksdb_approximateSizes, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, approximateMemtableStats, arginfo_rocksdb_approximateMemtableStats, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getStatistics, arginfo_rocksdb_getStatistics, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, setPerfLevel, arginfo_rocksdb_setPerfLevel, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_ME(RocksDB, resetPerfContext, arginfo_rocksdb_resetPerfContext, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_ME(RocksDB, getPerfContext, arginfo_rocksdb_getPerfContext, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_ME(RocksDB, profile, arginfo_rocksdb_profile, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_ME(RocksDB, scan,          arginfo_rocksdb_scan,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, parallelScan,  arginfo_rocksdb_parallelScan,  ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getSnapshot,   arginfo_rocksdb_getSnapshot,   ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getSnapshotStats, arginfo_rocksdb_getSnapshotStats, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, getColumnFamily,    arginfo_rocksdb_getColumnFamily,    ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, createColumnFamily, arginfo_rocksdb_createColumnFamily, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, dropColumnFamily,   arginfo_rocksdb_dropColumnFamily,   ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, listColumnFamilies, arginfo_rocksdb_listColumnFamilies, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, ingestExternalFiles, arginfo_rocksdb_ingestExternalFiles, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDB, beginTransaction,   arginfo_rocksdb_beginTransaction,   ZEND_ACC_PUBLIC)
   PHP_FE_END
 };
 
 static const zend_function_entry rocksdb_write_batch_methods[] = {
   PHP_ME(RocksDBWriteBatch, __construct, arginfo_rocksdb_writebatch___construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
   PHP_ME(RocksDBWriteBatch, put,         arginfo_rocksdb_writebatch_put,         ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBatch, merge,       arginfo_rocksdb_writebatch_merge,       ZEND_ACC_PUBLIC)
   PHP_ME(RocksDBWriteBatch, delete,      arginfo_rocksdb_writebatch_delete,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBatch, deleteRange, arginfo_rocksdb_writebatch_deleteRange, ZEND_ACC_PUBLIC)
   PHP_ME(RocksDBWriteBatch, clear,       arginfo_rocksdb_writebatch_clear,       ZEND_ACC_PUBLIC)
   PHP_FE_END
 };
@@ -825,12 +6648,103 @@ static const zend_function_entry rocksdb_iterator_methods[] = {
   PHP_ME(RocksDBIterator, current,     arginfo_rocksdb_iterator_current,     ZEND_ACC_PUBLIC)
   PHP_ME(RocksDBIterator, next,        arginfo_rocksdb_iterator_next,        ZEND_ACC_PUBLIC)
   PHP_ME(RocksDBIterator, rewind,      arginfo_rocksdb_iterator_rewind,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, prev,        arginfo_rocksdb_iterator_prev,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, seek,        arginfo_rocksdb_iterator_seek,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, seekForPrev, arginfo_rocksdb_iterator_seek,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, seekToFirst, arginfo_rocksdb_iterator_seekTo,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, seekToLast,  arginfo_rocksdb_iterator_seekTo,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, fetch,       arginfo_rocksdb_iterator_fetch,       ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBIterator, decodeValues, arginfo_rocksdb_iterator_decodeValues, ZEND_ACC_PUBLIC)
   PHP_ME(RocksDBIterator, destroy,     arginfo_rocksdb_iterator_destroy,     ZEND_ACC_PUBLIC)
   PHP_FE_END
 };
 
+static const zend_function_entry rocksdb_snapshot_methods[] = {
+  PHP_ME(RocksDBSnapshot, __construct,       arginfo_rocksdb_snapshot___construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+  PHP_ME(RocksDBSnapshot, getSequenceNumber, arginfo_rocksdb_snapshot_void,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBSnapshot, release,           arginfo_rocksdb_snapshot_void,        ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+static const zend_function_entry rocksdb_sst_file_writer_methods[] = {
+  PHP_ME(RocksDBSstFileWriter, __construct, arginfo_rocksdb_sst_file_writer___construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+  PHP_ME(RocksDBSstFileWriter, open,        arginfo_rocksdb_sst_file_writer_open,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBSstFileWriter, put,         arginfo_rocksdb_sst_file_writer_put,         ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBSstFileWriter, delete,      arginfo_rocksdb_sst_file_writer_delete,      ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBSstFileWriter, finish,      arginfo_rocksdb_sst_file_writer_void,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBSstFileWriter, getFileSize, arginfo_rocksdb_sst_file_writer_void,        ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+static const zend_function_entry rocksdb_column_family_methods[] = {
+  PHP_ME(RocksDBColumnFamily, getName, arginfo_rocksdb_column_family_getName, ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+static const zend_function_entry rocksdb_cache_methods[] = {
+  PHP_ME(RocksDBCache, __construct,    arginfo_rocksdb_cache___construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+  PHP_ME(RocksDBCache, getCapacity,    arginfo_rocksdb_cache_void,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBCache, setCapacity,    arginfo_rocksdb_cache_setCapacity, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBCache, getUsage,       arginfo_rocksdb_cache_void,        ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBCache, getPinnedUsage, arginfo_rocksdb_cache_void,        ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+static const zend_function_entry rocksdb_transaction_methods[] = {
+  PHP_ME(RocksDBTransaction, get,                 arginfo_rocksdb_transaction_get,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, getForUpdate,        arginfo_rocksdb_transaction_getForUpdate, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, put,                 arginfo_rocksdb_transaction_put,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, merge,               arginfo_rocksdb_transaction_put,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, delete,              arginfo_rocksdb_transaction_delete,       ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, commit,              arginfo_rocksdb_transaction_void,         ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, rollback,            arginfo_rocksdb_transaction_void,         ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, setSavePoint,        arginfo_rocksdb_transaction_void,         ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, rollbackToSavePoint, arginfo_rocksdb_transaction_void,         ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, getIterator,         arginfo_rocksdb_transaction_getIterator,  ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBTransaction, prefixSearch,        arginfo_rocksdb_transaction_prefixSearch, ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+static const zend_function_entry rocksdb_write_buffer_manager_methods[] = {
+  PHP_ME(RocksDBWriteBufferManager, __construct,           arginfo_rocksdb_write_buffer_manager___construct,   ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+  PHP_ME(RocksDBWriteBufferManager, getBufferSize,         arginfo_rocksdb_write_buffer_manager_void,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBufferManager, setBufferSize,         arginfo_rocksdb_write_buffer_manager_setBufferSize, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBufferManager, setAllowStall,         arginfo_rocksdb_write_buffer_manager_setAllowStall, ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBufferManager, getMemoryUsage,        arginfo_rocksdb_write_buffer_manager_void,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBufferManager, getMutableMemoryUsage, arginfo_rocksdb_write_buffer_manager_void,          ZEND_ACC_PUBLIC)
+  PHP_ME(RocksDBWriteBufferManager, getCacheUsage,         arginfo_rocksdb_write_buffer_manager_void,          ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+static const zend_function_entry rocksdb_rate_limiter_methods[] = {
+  PHP_ME(RocksDBRateLimiter, __construct, arginfo_rocksdb_rate_limiter___construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+  PHP_FE_END
+};
+
 /* ------------------- Module Init / Shutdown / Info ------------------- */
 
+static PHP_GINIT_FUNCTION(rocksdb)
+{
+#if defined(COMPILE_DL_ROCKSDB) && defined(ZTS)
+  ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+  zend_hash_init(&rocksdb_globals->persistent_dbs, 8, NULL,
+                 php_rocksdb_persistent_dtor, 1);
+  /* Entries remove themselves when their last holder releases them */
+  zend_hash_init(&rocksdb_globals->write_buffer_managers, 4, NULL, NULL, 1);
+  zend_hash_init(&rocksdb_globals->rate_limiters, 4, NULL, NULL, 1);
+  rocksdb_globals->perf_level = rocksdb_disable;
+}
+
+/* Closes every persistent handle; runs at module shutdown (per thread in ZTS).
+   The handles release their shared managers, so the registries go last. */
+static PHP_GSHUTDOWN_FUNCTION(rocksdb)
+{
+  zend_hash_destroy(&rocksdb_globals->persistent_dbs);
+  zend_hash_destroy(&rocksdb_globals->write_buffer_managers);
+  zend_hash_destroy(&rocksdb_globals->rate_limiters);
+}
+
 PHP_MINIT_FUNCTION(rocksdb)
 {
   zend_class_entry ce;
@@ -838,6 +6752,7 @@ PHP_MINIT_FUNCTION(rocksdb)
   INIT_CLASS_ENTRY(ce, "RocksDB", rocksdb_methods);
   php_rocksdb_ce = zend_register_internal_class(&ce);
   php_rocksdb_ce->create_object = php_rocksdb_object_new;
+  zend_class_implements(php_rocksdb_ce, 1, zend_ce_aggregate);
   memcpy(&rocksdb_object_handlers, zend_get_std_object_handlers(),
          sizeof(zend_object_handlers));
   rocksdb_object_handlers.offset =
@@ -853,6 +6768,38 @@ PHP_MINIT_FUNCTION(rocksdb)
     sizeof("LZ4_COMPRESSION")-1, rocksdb_lz4_compression);
   zend_declare_class_constant_long(php_rocksdb_ce, "ZSTD_COMPRESSION",
     sizeof("ZSTD_COMPRESSION")-1, rocksdb_zstd_compression);
+  zend_declare_class_constant_long(php_rocksdb_ce, "BLOOM_FILTER",
+    sizeof("BLOOM_FILTER")-1, PHP_ROCKSDB_BLOOM_FILTER);
+  zend_declare_class_constant_long(php_rocksdb_ce, "RIBBON_FILTER",
+    sizeof("RIBBON_FILTER")-1, PHP_ROCKSDB_RIBBON_FILTER);
+  zend_declare_class_constant_long(php_rocksdb_ce, "STATS_EXCEPT_HISTOGRAM_OR_TIMERS",
+    sizeof("STATS_EXCEPT_HISTOGRAM_OR_TIMERS")-1, rocksdb_statistics_level_except_histogram_or_timers);
+  zend_declare_class_constant_long(php_rocksdb_ce, "STATS_EXCEPT_TIMERS",
+    sizeof("STATS_EXCEPT_TIMERS")-1, rocksdb_statistics_level_except_timers);
+  zend_declare_class_constant_long(php_rocksdb_ce, "STATS_EXCEPT_DETAILED_TIMERS",
+    sizeof("STATS_EXCEPT_DETAILED_TIMERS")-1, rocksdb_statistics_level_except_detailed_timers);
+  zend_declare_class_constant_long(php_rocksdb_ce, "STATS_EXCEPT_TIME_FOR_MUTEX",
+    sizeof("STATS_EXCEPT_TIME_FOR_MUTEX")-1, rocksdb_statistics_level_except_time_for_mutex);
+  zend_declare_class_constant_long(php_rocksdb_ce, "STATS_ALL",
+    sizeof("STATS_ALL")-1, rocksdb_statistics_level_all);
+  zend_declare_class_constant_long(php_rocksdb_ce, "PERF_DISABLE",
+    sizeof("PERF_DISABLE")-1, rocksdb_disable);
+  zend_declare_class_constant_long(php_rocksdb_ce, "PERF_ENABLE_COUNT",
+    sizeof("PERF_ENABLE_COUNT")-1, rocksdb_enable_count);
+  zend_declare_class_constant_long(php_rocksdb_ce, "PERF_ENABLE_TIME_EXCEPT_FOR_MUTEX",
+    sizeof("PERF_ENABLE_TIME_EXCEPT_FOR_MUTEX")-1, rocksdb_enable_time_except_for_mutex);
+  zend_declare_class_constant_long(php_rocksdb_ce, "PERF_ENABLE_TIME",
+    sizeof("PERF_ENABLE_TIME")-1, rocksdb_enable_time);
+  zend_declare_class_constant_long(php_rocksdb_ce, "SCAN_COUNT",
+    sizeof("SCAN_COUNT")-1, PHP_ROCKSDB_SCAN_COUNT);
+  zend_declare_class_constant_long(php_rocksdb_ce, "SCAN_BYTES",
+    sizeof("SCAN_BYTES")-1, PHP_ROCKSDB_SCAN_BYTES);
+  zend_declare_class_constant_long(php_rocksdb_ce, "SCAN_MIN_MAX",
+    sizeof("SCAN_MIN_MAX")-1, PHP_ROCKSDB_SCAN_MIN_MAX);
+  zend_declare_class_constant_long(php_rocksdb_ce, "SCAN_CHECKSUM",
+    sizeof("SCAN_CHECKSUM")-1, PHP_ROCKSDB_SCAN_CHECKSUM);
+  zend_declare_class_constant_long(php_rocksdb_ce, "SCAN_ALL",
+    sizeof("SCAN_ALL")-1, PHP_ROCKSDB_SCAN_ALL);
 
   INIT_CLASS_ENTRY(ce, "RocksDBWriteBatch", rocksdb_write_batch_methods);
   php_rocksdb_write_batch_ce = zend_register_internal_class(&ce);
@@ -867,6 +6814,9 @@ PHP_MINIT_FUNCTION(rocksdb)
   INIT_CLASS_ENTRY(ce, "RocksDBIterator", rocksdb_iterator_methods);
   php_rocksdb_iterator_ce = zend_register_internal_class(&ce);
   php_rocksdb_iterator_ce->create_object = php_rocksdb_iterator_object_new;
+  /* Must be set before implementing Iterator so foreach keeps the native path */
+  php_rocksdb_iterator_ce->get_iterator = php_rocksdb_iterator_get_iterator;
+  zend_class_implements(php_rocksdb_iterator_ce, 1, zend_ce_iterator);
   memcpy(&rocksdb_iterator_object_handlers, zend_get_std_object_handlers(),
          sizeof(zend_object_handlers));
   rocksdb_iterator_object_handlers.offset =
@@ -874,6 +6824,94 @@ PHP_MINIT_FUNCTION(rocksdb)
   rocksdb_iterator_object_handlers.free_obj =
     php_rocksdb_iterator_object_free;
 
+  zend_declare_class_constant_long(php_rocksdb_iterator_ce, "KEYS_AND_VALUES",
+    sizeof("KEYS_AND_VALUES")-1, PHP_ROCKSDB_FETCH_KEYS_AND_VALUES);
+  zend_declare_class_constant_long(php_rocksdb_iterator_ce, "KEYS_ONLY",
+    sizeof("KEYS_ONLY")-1, PHP_ROCKSDB_FETCH_KEYS_ONLY);
+  zend_declare_class_constant_long(php_rocksdb_iterator_ce, "VALUES_ONLY",
+    sizeof("VALUES_ONLY")-1, PHP_ROCKSDB_FETCH_VALUES_ONLY);
+  zend_declare_class_constant_long(php_rocksdb_iterator_ce, "DECODE_VALUES",
+    sizeof("DECODE_VALUES")-1, PHP_ROCKSDB_FETCH_DECODE_VALUES);
+
+  INIT_CLASS_ENTRY(ce, "RocksDBCache", rocksdb_cache_methods);
+  php_rocksdb_cache_ce = zend_register_internal_class(&ce);
+  php_rocksdb_cache_ce->create_object = php_rocksdb_cache_object_new;
+  memcpy(&rocksdb_cache_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_cache_object_handlers.offset =
+    XtOffsetOf(rocksdb_cache_object, std);
+  rocksdb_cache_object_handlers.free_obj =
+    php_rocksdb_cache_object_free;
+  rocksdb_cache_object_handlers.clone_obj = NULL;
+
+  INIT_CLASS_ENTRY(ce, "RocksDBWriteBufferManager", rocksdb_write_buffer_manager_methods);
+  php_rocksdb_write_buffer_manager_ce = zend_register_internal_class(&ce);
+  php_rocksdb_write_buffer_manager_ce->create_object = php_rocksdb_write_buffer_manager_object_new;
+  memcpy(&rocksdb_write_buffer_manager_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_write_buffer_manager_object_handlers.offset =
+    XtOffsetOf(rocksdb_write_buffer_manager_object, std);
+  rocksdb_write_buffer_manager_object_handlers.free_obj =
+    php_rocksdb_write_buffer_manager_object_free;
+  rocksdb_write_buffer_manager_object_handlers.clone_obj = NULL;
+
+  INIT_CLASS_ENTRY(ce, "RocksDBRateLimiter", rocksdb_rate_limiter_methods);
+  php_rocksdb_rate_limiter_ce = zend_register_internal_class(&ce);
+  php_rocksdb_rate_limiter_ce->create_object = php_rocksdb_rate_limiter_object_new;
+  memcpy(&rocksdb_rate_limiter_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_rate_limiter_object_handlers.offset =
+    XtOffsetOf(rocksdb_rate_limiter_object, std);
+  rocksdb_rate_limiter_object_handlers.free_obj =
+    php_rocksdb_rate_limiter_object_free;
+  rocksdb_rate_limiter_object_handlers.clone_obj = NULL;
+
+  INIT_CLASS_ENTRY(ce, "RocksDBSnapshot", rocksdb_snapshot_methods);
+  php_rocksdb_snapshot_ce = zend_register_internal_class(&ce);
+  php_rocksdb_snapshot_ce->create_object = php_rocksdb_snapshot_object_new;
+  memcpy(&rocksdb_snapshot_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_snapshot_object_handlers.offset =
+    XtOffsetOf(rocksdb_snapshot_object, std);
+  rocksdb_snapshot_object_handlers.free_obj =
+    php_rocksdb_snapshot_object_free;
+  rocksdb_snapshot_object_handlers.clone_obj = NULL;
+
+  INIT_CLASS_ENTRY(ce, "RocksDBColumnFamily", rocksdb_column_family_methods);
+  php_rocksdb_column_family_ce = zend_register_internal_class(&ce);
+  php_rocksdb_column_family_ce->ce_flags |= ZEND_ACC_FINAL;
+  php_rocksdb_column_family_ce->create_object = php_rocksdb_column_family_object_new;
+  memcpy(&rocksdb_column_family_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_column_family_object_handlers.offset =
+    XtOffsetOf(rocksdb_column_family_object, std);
+  rocksdb_column_family_object_handlers.free_obj =
+    php_rocksdb_column_family_object_free;
+  rocksdb_column_family_object_handlers.clone_obj = NULL;
+
+  INIT_CLASS_ENTRY(ce, "RocksDBTransaction", rocksdb_transaction_methods);
+  php_rocksdb_transaction_ce = zend_register_internal_class(&ce);
+  php_rocksdb_transaction_ce->ce_flags |= ZEND_ACC_FINAL;
+  php_rocksdb_transaction_ce->create_object = php_rocksdb_transaction_object_new;
+  memcpy(&rocksdb_transaction_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_transaction_object_handlers.offset =
+    XtOffsetOf(rocksdb_transaction_object, std);
+  rocksdb_transaction_object_handlers.free_obj =
+    php_rocksdb_transaction_object_free;
+  rocksdb_transaction_object_handlers.clone_obj = NULL;
+
+  INIT_CLASS_ENTRY(ce, "RocksDBSstFileWriter", rocksdb_sst_file_writer_methods);
+  php_rocksdb_sst_file_writer_ce = zend_register_internal_class(&ce);
+  php_rocksdb_sst_file_writer_ce->create_object = php_rocksdb_sst_file_writer_object_new;
+  memcpy(&rocksdb_sst_file_writer_object_handlers, zend_get_std_object_handlers(),
+         sizeof(zend_object_handlers));
+  rocksdb_sst_file_writer_object_handlers.offset =
+    XtOffsetOf(rocksdb_sst_file_writer_object, std);
+  rocksdb_sst_file_writer_object_handlers.free_obj =
+    php_rocksdb_sst_file_writer_object_free;
+  rocksdb_sst_file_writer_object_handlers.clone_obj = NULL;
+
   INIT_CLASS_ENTRY(ce, "RocksDBException", NULL);
   php_rocksdb_exception_ce =
     zend_register_internal_class_ex(&ce, zend_exception_get_default());
@@ -886,11 +6924,31 @@ PHP_MSHUTDOWN_FUNCTION(rocksdb)
   return SUCCESS;
 }
 
+/* A sampled request that enabled perf counters must not leave them on for
+   the next request served by this thread */
+PHP_RSHUTDOWN_FUNCTION(rocksdb)
+{
+  if (ROCKSDB_G(perf_level) != rocksdb_disable) {
+    rocksdb_set_perf_level(rocksdb_disable);
+    ROCKSDB_G(perf_level) = rocksdb_disable;
+  }
+  return SUCCESS;
+}
+
 PHP_MINFO_FUNCTION(rocksdb)
 {
   php_info_print_table_start();
   php_info_print_table_header(2, "RocksDB support", "enabled");
   php_info_print_table_row(2, "Extension Version", PHP_ROCKSDB_VERSION);
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%u", zend_hash_num_elements(&ROCKSDB_G(persistent_dbs)));
+    php_info_print_table_row(2, "Persistent handles", buf);
+    snprintf(buf, sizeof(buf), "%u", zend_hash_num_elements(&ROCKSDB_G(write_buffer_managers)));
+    php_info_print_table_row(2, "Shared write buffer managers", buf);
+    snprintf(buf, sizeof(buf), "%u", zend_hash_num_elements(&ROCKSDB_G(rate_limiters)));
+    php_info_print_table_row(2, "Shared rate limiters", buf);
+  }
   php_info_print_table_end();
 }
 
@@ -901,10 +6959,14 @@ zend_module_entry rocksdb_module_entry = {
   PHP_MINIT(rocksdb),
   PHP_MSHUTDOWN(rocksdb),
   NULL,
-  NULL,
+  PHP_RSHUTDOWN(rocksdb),
   PHP_MINFO(rocksdb),
   PHP_ROCKSDB_VERSION,
-  STANDARD_MODULE_PROPERTIES
+  PHP_MODULE_GLOBALS(rocksdb),
+  PHP_GINIT(rocksdb),
+  PHP_GSHUTDOWN(rocksdb),
+  NULL,
+  STANDARD_MODULE_PROPERTIES_EX
 };
 
 #ifdef COMPILE_DL_ROCKSDB
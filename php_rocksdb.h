@@ -14,8 +14,23 @@ extern zend_module_entry rocksdb_module_entry;
 # define PHP_ROCKSDB_API
 #endif
 
+ZEND_BEGIN_MODULE_GLOBALS(rocksdb)
+  HashTable persistent_dbs;   /* "mode:path:signature" => php_rocksdb_persistent* */
+  HashTable write_buffer_managers; /* constructor arguments => shared manager */
+  HashTable rate_limiters;
+  int perf_level;             /* last level given to rocksdb_set_perf_level() */
+ZEND_END_MODULE_GLOBALS(rocksdb)
+
+ZEND_EXTERN_MODULE_GLOBALS(rocksdb)
+#define ROCKSDB_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(rocksdb, v)
+
+#if defined(ZTS) && defined(COMPILE_DL_ROCKSDB)
+ZEND_TSRMLS_CACHE_EXTERN()
+#endif
+
 PHP_MINIT_FUNCTION(rocksdb);
 PHP_MSHUTDOWN_FUNCTION(rocksdb);
+PHP_RSHUTDOWN_FUNCTION(rocksdb);
 PHP_MINFO_FUNCTION(rocksdb);
 
 #endif /* PHP_ROCKSDB_H */
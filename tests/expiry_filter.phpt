@@ -0,0 +1,158 @@
+--TEST--
+RocksDB 'expiry_filter': per-entry TTLs hidden from every read path and dropped by compaction
+--EXTENSIONS--
+rocksdb
+--FILE--
+<?php
+$path = sys_get_temp_dir() . '/php-rocksdb-expiry-' . getmypid();
+$db = new RocksDB($path, ['create_if_missing' => true, 'expiry_filter' => true]);
+
+/* A value that looks like a framed one must still round-trip */
+$lookalike = "\xFE\xE7" . str_repeat("\0", 8) . 'payload';
+$db->put('0:short', 'first', null, null, 2);
+$db->put('a:live', 'forever');
+$db->put('a:long', 'later', null, null, 3600);
+$db->put('a:magic', $lookalike);
+$db->put('a:short', 'soon', null, null, 2);
+$db->putValue('a:value', ['x' => 1], null, null, 2);
+$db->put('b:live', 'also forever');
+$db->put('z:short', 'last', null, null, 2);
+var_dump($db->get('a:short'));
+var_dump($db->getValue('a:value'));
+
+sleep(3);
+
+echo "-- point reads\n";
+var_dump($db->get('a:short'), $db->getValue('a:value'), $db->get('a:live'), $db->get('a:long'));
+var_dump($db->get('a:magic') === $lookalike);
+var_dump($db->multiGet(['a:short', 'a:live', 'a:value']));
+
+echo "-- iterators\n";
+$it = $db->getIterator();
+$keys = [];
+foreach ($it as $key => $value) {
+  $keys[] = $key;
+}
+echo implode(',', $keys), "\n";
+/* key()/current() step over expired entries without a valid() first */
+$it->seek('a:short');
+var_dump($it->key(), $it->current());
+$it->seekForPrev('a:value');
+var_dump($it->key());
+$it->seekToLast();
+var_dump($it->key());
+$it->seekToFirst();
+var_dump($it->key());
+echo implode(',', array_keys($it->fetch(10))), "\n";
+unset($it);
+
+echo "-- scan\n";
+echo implode(',', array_keys($db->scan())), "\n";
+echo implode(',', array_keys($db->scan(null, null, 0, true))), "\n";
+echo implode(',', array_keys($db->scan(null, null, 2))), "\n";
+
+echo "-- parallelScan\n";
+$stats = $db->parallelScan(null, null, 1, RocksDB::SCAN_ALL);
+var_dump($stats['count'], $stats['key_bytes'], $stats['value_bytes'], $stats['min_key'], $stats['max_key']);
+$plain = new RocksDB("$path-plain", ['create_if_missing' => true]);
+foreach (['a:live' => 'forever', 'a:long' => 'later', 'a:magic' => $lookalike, 'b:live' => 'also forever'] as $k => $v) {
+  $plain->put($k, $v);
+}
+var_dump($stats['checksum'] === $plain->parallelScan(null, null, 1, RocksDB::SCAN_ALL)['checksum']);
+unset($plain);
+
+echo "-- unframed writes\n";
+$ambiguous = "\xFE\xE7" . str_repeat("\0", 8) . 'x';
+try {
+  $db->merge('m', $ambiguous);
+} catch (RocksDBException $e) {
+  echo $e->getMessage(), "\n";
+}
+$batch = new RocksDBWriteBatch();
+$batch->put('m', $ambiguous);
+try {
+  $db->write($batch);
+} catch (RocksDBException $e) {
+  echo $e->getMessage(), "\n";
+}
+$batch = new RocksDBWriteBatch();
+$batch->merge('m', $ambiguous);
+try {
+  $db->write($batch);
+} catch (RocksDBException $e) {
+  echo $e->getMessage(), "\n";
+}
+$batch->clear();
+$batch->put('m', 'plain');
+var_dump($db->write($batch), $db->get('m'));
+
+echo "-- compaction\n";
+$db->compactRange();
+unset($db);
+/* Without the option the stored bytes show through */
+$db = new RocksDB($path);
+var_dump($db->get('0:short'), $db->get('a:short'), $db->get('a:value'), $db->get('z:short'));
+var_dump(bin2hex($db->get('a:live')));
+var_dump(substr($db->get('a:long'), 0, 2) === "\xFE\xE7", substr($db->get('a:long'), 10));
+var_dump($db->get('m'));
+
+unset($db);
+foreach ([$path, "$path-plain"] as $dir) {
+  array_map('unlink', glob("$dir/*"));
+  rmdir($dir);
+}
+?>
+--EXPECT--
+string(4) "soon"
+array(1) {
+  ["x"]=>
+  int(1)
+}
+-- point reads
+NULL
+NULL
+string(7) "forever"
+string(5) "later"
+bool(true)
+array(3) {
+  ["a:short"]=>
+  NULL
+  ["a:live"]=>
+  string(7) "forever"
+  ["a:value"]=>
+  NULL
+}
+-- iterators
+a:live,a:long,a:magic,b:live
+string(6) "b:live"
+string(12) "also forever"
+string(7) "a:magic"
+string(6) "b:live"
+string(6) "a:live"
+a:live,a:long,a:magic,b:live
+-- scan
+a:live,a:long,a:magic,b:live
+b:live,a:magic,a:long,a:live
+a:live,a:long
+-- parallelScan
+int(4)
+int(25)
+int(41)
+string(6) "a:live"
+string(6) "b:live"
+bool(true)
+-- unframed writes
+Value starts with the expiry header bytes (0xFE 0xE7); use put() on a DB with 'expiry_filter'
+Write batch holds a value starting with the expiry header bytes (0xFE 0xE7); use put() on a DB with 'expiry_filter'
+Write batch holds a value starting with the expiry header bytes (0xFE 0xE7); use put() on a DB with 'expiry_filter'
+bool(true)
+string(5) "plain"
+-- compaction
+NULL
+NULL
+NULL
+NULL
+string(34) "fee70000000000000000666f7265766572"
+bool(true)
+string(5) "later"
+string(5) "plain"
@@ -0,0 +1,44 @@
+--TEST--
+RocksDBIterator: reverse iteration over a prefixSearch() with a prefix extractor
+--EXTENSIONS--
+rocksdb
+--FILE--
+<?php
+$path = sys_get_temp_dir() . '/php-rocksdb-prefix-reverse-' . getmypid();
+$db = new RocksDB($path, ['create_if_missing' => true, 'prefix_extractor' => 2]);
+foreach (['aa1', 'ab1', 'ab2', 'ab3', 'ac1'] as $key) {
+  $db->put($key, strtoupper($key));
+}
+
+$it = $db->prefixSearch('ab');
+for ($it->seekToLast(); $it->valid(); $it->prev()) {
+  echo $it->key(), '=', $it->current(), "\n";
+}
+
+$it = $db->prefixSearch('ab');
+$it->seekForPrev('ab2');
+var_dump($it->key());
+
+/* Turning around mid-scan keeps the position */
+$it = $db->prefixSearch('ab');
+$it->next();
+$it->prev();
+var_dump($it->key());
+
+/* A prefix with no successor has no upper bound */
+$db->put("\xff\xff1", 'x');
+$it = $db->prefixSearch("\xff\xff");
+$it->seekToLast();
+var_dump(bin2hex($it->key()));
+
+unset($it, $db);
+array_map('unlink', glob("$path/*"));
+rmdir($path);
+?>
+--EXPECT--
+ab3=AB3
+ab2=AB2
+ab1=AB1
+string(3) "ab2"
+string(3) "ab1"
+string(6) "ffff31"
@@ -0,0 +1,127 @@
+--TEST--
+RocksDB 'merge_operator': add, max, min and append through merge() and RocksDBWriteBatch::merge()
+--EXTENSIONS--
+rocksdb
+--FILE--
+<?php
+$base = sys_get_temp_dir() . '/php-rocksdb-merge-' . getmypid();
+$dirs = [];
+
+function open_db(string $path, array $options): RocksDB {
+  global $dirs;
+  $dirs[$path] = true;
+  return new RocksDB($path, ['create_if_missing' => true] + $options);
+}
+
+/* The first half of the operands goes through merge(); compactRange() then
+   flushes them (partial merge of the stacked operands) and folds them into
+   the base (full merge). The rest arrives in one write batch and is folded
+   at read time. */
+function merged(RocksDB $db, string $key, ?string $value, array $operands) {
+  if ($value !== null) {
+    $db->put($key, $value);
+  }
+  $half = (int)ceil(count($operands) / 2);
+  foreach (array_slice($operands, 0, $half) as $operand) {
+    $db->merge($key, $operand);
+  }
+  $db->compactRange();
+  $batch = new RocksDBWriteBatch();
+  foreach (array_slice($operands, $half) as $operand) {
+    $batch->merge($key, $operand);
+  }
+  $db->write($batch);
+  return $db->get($key);
+}
+
+$cases = [
+  'add' => [
+    [null, ['5', '-2', 'x', '10']],
+    ['10', ['5', '7']],
+    ['abc', ['4']],
+    [null, ['x', 'y']],
+    [(string)PHP_INT_MAX, ['1']],
+  ],
+  'max' => [
+    [null, ['3', '9', '4']],
+    ['abc', ['2']],
+    ['7', ['x']],
+    [null, ['x']],
+  ],
+  'min' => [
+    [null, ['3', '9', '-4']],
+    ['1', ['5']],
+  ],
+  'append' => [
+    [null, ['x', 'y', 'z']],
+    ['base', ['c']],
+  ],
+];
+foreach ($cases as $operator => $list) {
+  $db = open_db("$base-$operator", ['merge_operator' => $operator]);
+  foreach ($list as $i => [$value, $operands]) {
+    echo "$operator #$i: ";
+    var_dump(merged($db, "k$i", $value, $operands));
+  }
+  unset($db);
+}
+
+foreach (['|', '', '::'] as $i => $delimiter) {
+  $db = open_db("$base-delim$i", ['merge_operator' => ['type' => 'append', 'delimiter' => $delimiter]]);
+  echo "append '$delimiter': ";
+  var_dump(merged($db, 'k', 'a', ['b', 'c', 'd']));
+  unset($db);
+}
+
+echo "-- over expiry-framed values\n";
+$path = "$base-expiry";
+$db = open_db($path, ['merge_operator' => 'add', 'expiry_filter' => true]);
+$db->put('expired', '100', null, null, 2);
+sleep(3);
+var_dump(merged($db, 'plain', '5', ['3']));
+$db->put('ttl', '10', null, null, 3600);
+var_dump(merged($db, 'ttl', null, ['1', '2']));
+var_dump($db->get('expired'));
+var_dump(merged($db, 'expired', null, ['1']));
+$db->compactRange();
+unset($db);
+/* The folded values keep their header */
+$db = open_db($path, ['merge_operator' => 'add']);
+var_dump(bin2hex($db->get('plain')));
+$ttl = $db->get('ttl');
+var_dump(substr($ttl, 0, 2) === "\xFE\xE7", unpack('J', substr($ttl, 2, 8))[1] > time(), substr($ttl, 10));
+var_dump($db->get('expired'));
+unset($db);
+
+foreach (array_keys($dirs) as $dir) {
+  array_map('unlink', glob("$dir/*"));
+  rmdir($dir);
+}
+?>
+--EXPECT--
+add #0: string(2) "13"
+add #1: string(2) "22"
+add #2: string(1) "4"
+add #3: string(1) "0"
+add #4: string(20) "-9223372036854775808"
+max #0: string(1) "9"
+max #1: string(1) "2"
+max #2: string(1) "7"
+max #3: string(0) ""
+min #0: string(2) "-4"
+min #1: string(1) "1"
+append #0: string(5) "x,y,z"
+append #1: string(6) "base,c"
+append '|': string(7) "a|b|c|d"
+append '': string(4) "abcd"
+append '::': string(10) "a::b::c::d"
+-- over expiry-framed values
+string(1) "8"
+string(2) "13"
+NULL
+string(1) "1"
+string(22) "fee7000000000000000038"
+bool(true)
+bool(true)
+string(2) "13"
+string(1) "1"
@@ -0,0 +1,92 @@
+--TEST--
+RocksDB::parallelScan(): results independent of the thread count, shards tile the range
+--EXTENSIONS--
+rocksdb
+--FILE--
+<?php
+$path = sys_get_temp_dir() . '/php-rocksdb-parallel-scan-' . getmypid();
+/* Small uncompressed files so the range has SST boundaries to split at */
+$db = new RocksDB($path, [
+  'create_if_missing'      => true,
+  'compression'            => RocksDB::NO_COMPRESSION,
+  'bottommost_compression' => RocksDB::NO_COMPRESSION,
+  'target_file_size_base'  => 65536,
+]);
+for ($i = 0; $i < 4000; $i++) {
+  $db->put(sprintf('k%05d', $i), str_repeat(md5((string)$i), 8));
+}
+$db->compactRange();
+
+function check_tiling(array $stats, ?string $start, ?string $end): bool {
+  $shards = $stats['shards'];
+  $count = 0;
+  if ($shards[0]['start'] !== $start || $shards[count($shards) - 1]['end'] !== $end) {
+    return false;
+  }
+  foreach ($shards as $i => $shard) {
+    if ($i > 0 && $shard['start'] !== $shards[$i - 1]['end']) {
+      return false;
+    }
+    if ($shard['start'] !== null && $shard['end'] !== null && strcmp($shard['start'], $shard['end']) >= 0) {
+      return false;
+    }
+    /* Every key a shard saw lies inside its own bounds */
+    if ($shard['min_key'] !== null
+        && (($shard['start'] !== null && strcmp($shard['min_key'], $shard['start']) < 0)
+          || ($shard['end'] !== null && strcmp($shard['max_key'], $shard['end']) >= 0))) {
+      return false;
+    }
+    $count += $shard['count'];
+  }
+  return $count === $stats['count'];
+}
+
+foreach ([[null, null], ['k01000', 'k03000'], ['k03999', null]] as [$start, $end]) {
+  $one = $db->parallelScan($start, $end, 1, RocksDB::SCAN_ALL);
+  echo var_export($start, true), ' .. ', var_export($end, true), ': ';
+  echo $one['count'], ' rows, ', $one['key_bytes'], ' key bytes, ', $one['value_bytes'], ' value bytes, ',
+    $one['min_key'], ' .. ', $one['max_key'], "\n";
+  var_dump(count($one['shards']), check_tiling($one, $start, $end));
+  foreach ([4, 0] as $threads) {
+    $many = $db->parallelScan($start, $end, $threads, RocksDB::SCAN_ALL);
+    $same = true;
+    foreach (['count', 'key_bytes', 'value_bytes', 'min_key', 'max_key', 'checksum'] as $field) {
+      $same = $same && $one[$field] === $many[$field];
+    }
+    var_dump($same, check_tiling($many, $start, $end));
+  }
+}
+
+/* The full range has enough files to actually split */
+var_dump(count($db->parallelScan(null, null, 4)['shards']) > 1);
+var_dump($db->parallelScan(null, null, 4, RocksDB::SCAN_COUNT | RocksDB::SCAN_CHECKSUM)['checksum']
+  === $db->parallelScan(null, null, 1, RocksDB::SCAN_ALL)['checksum']);
+
+unset($db);
+array_map('unlink', glob("$path/*"));
+rmdir($path);
+?>
+--EXPECT--
+NULL .. NULL: 4000 rows, 24000 key bytes, 1024000 value bytes, k00000 .. k03999
+int(1)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+'k01000' .. 'k03000': 2000 rows, 12000 key bytes, 512000 value bytes, k01000 .. k02999
+int(1)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+'k03999' .. NULL: 1 rows, 6 key bytes, 256 value bytes, k03999 .. k03999
+int(1)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
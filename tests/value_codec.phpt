@@ -0,0 +1,158 @@
+--TEST--
+RocksDB::putValue()/getValue(): value codec round-trips, depth limit and damaged input
+--EXTENSIONS--
+rocksdb
+--FILE--
+<?php
+$path = sys_get_temp_dir() . '/php-rocksdb-value-codec-' . getmypid();
+$db = new RocksDB($path, ['create_if_missing' => true]);
+
+$cases = [
+  'bool_false'   => false,
+  'bool_true'    => true,
+  'empty_list'   => [],
+  'empty_string' => '',
+  'binary'       => "\0\x01\xfe\xe7\xff",
+  'float'        => 1.5,
+  'float_tiny'   => -2.75e-300,
+  'float_inf'    => INF,
+  'int_list'     => [0, -1, 1, PHP_INT_MAX, PHP_INT_MIN],
+  'int_max'      => PHP_INT_MAX,
+  'int_min'      => PHP_INT_MIN,
+  'int_minus'    => -1,
+  'int_zero'     => 0,
+  'int_keys'     => [5 => 'five', -3 => 'minus three', 0 => 'zero'],
+  'mixed_list'   => [1, 'two', 3.0, null, false],
+  'nested'       => ['a' => ['b' => [1, 2, 'x'], 7 => null], 'c' => [['d' => 1.25]], '' => []],
+  'null'         => null,
+];
+foreach ($cases as $key => $value) {
+  $db->putValue($key, $value);
+  echo $key, ': ', var_export($db->getValue($key) === $value, true), "\n";
+}
+
+echo "multiGetValues: ", var_export($db->multiGetValues(array_keys($cases)) === $cases, true), "\n";
+
+$sorted = $cases;
+ksort($sorted, SORT_STRING);
+$it = $db->getIterator();
+$it->seekToFirst();
+echo "fetch DECODE_VALUES: ", var_export($it->fetch(100, RocksDBIterator::DECODE_VALUES) === $sorted, true), "\n";
+$it = $db->getIterator();
+$it->decodeValues();
+$seen = [];
+foreach ($it as $key => $value) {
+  $seen[$key] = $value;
+}
+echo "foreach decodeValues: ", var_export($seen === $sorted, true), "\n";
+unset($it);
+
+$db->putValue('float_nan', NAN);
+var_dump(is_nan($db->getValue('float_nan')));
+var_dump($db->getValue('missing'));
+
+/* 256 nested arrays fit, 257 do not */
+$deep = [];
+for ($i = 1; $i < 256; $i++) {
+  $deep = [$deep];
+}
+$db->putValue('deep', $deep);
+var_dump($db->getValue('deep') === $deep);
+try {
+  $db->putValue('deeper', [$deep]);
+} catch (RocksDBException $e) {
+  echo $e->getMessage(), "\n";
+}
+try {
+  $db->putValue('object', new stdClass());
+} catch (RocksDBException $e) {
+  echo $e->getMessage(), "\n";
+}
+
+/* Hand-made input nested past the limit must not be decoded either */
+$db->put('deep_raw', "\xC1" . str_repeat("\x06\x01", 257) . "\x00");
+
+/* Every truncation of a valid encoding has to be rejected */
+$db->putValue('whole', $cases['nested']);
+$whole = $db->get('whole');
+$rejected = 0;
+for ($len = 0; $len < strlen($whole); $len++) {
+  $db->put('truncated', substr($whole, 0, $len));
+  try {
+    $db->getValue('truncated');
+  } catch (RocksDBException $e) {
+    $rejected++;
+  }
+}
+var_dump($rejected === strlen($whole));
+
+$corrupt = [
+  'deep_raw'       => $db->get('deep_raw'),
+  'plain'          => 'hello',
+  'version'        => "\xC2\x00",
+  'unknown_tag'    => "\xC1\x09",
+  'trailing'       => "\xC1\x00\x00",
+  'long_varint'    => "\xC1\x03" . str_repeat("\xff", 11),
+  'short_double'   => "\xC1\x04\x00\x00\x00",
+  'string_overrun' => "\xC1\x05\x10abc",
+  'huge_count'     => "\xC1\x06\xff\xff\xff\xff\x0f\x00",
+  'bad_map_key'    => "\xC1\x08\x01\x00\x00",
+];
+foreach ($corrupt as $name => $bytes) {
+  $db->put($name, $bytes);
+  try {
+    $db->getValue($name);
+    echo "$name: decoded\n";
+  } catch (RocksDBException $e) {
+    echo "$name: ", $e->getMessage(), "\n";
+  }
+}
+var_dump($db->multiGetValues(['plain', 'null']));
+
+unset($db);
+array_map('unlink', glob("$path/*"));
+rmdir($path);
+?>
+--EXPECT--
+bool_false: true
+bool_true: true
+empty_list: true
+empty_string: true
+binary: true
+float: true
+float_tiny: true
+float_inf: true
+int_list: true
+int_max: true
+int_min: true
+int_minus: true
+int_zero: true
+int_keys: true
+mixed_list: true
+nested: true
+null: true
+multiGetValues: true
+fetch DECODE_VALUES: true
+foreach decodeValues: true
+bool(true)
+NULL
+bool(true)
+Cannot encode arrays nested deeper than 256 levels
+Cannot encode a value of type object
+bool(true)
+deep_raw: Value is not in the RocksDB value format
+plain: Value is not in the RocksDB value format
+version: Value is not in the RocksDB value format
+unknown_tag: Value is not in the RocksDB value format
+trailing: Value is not in the RocksDB value format
+long_varint: Value is not in the RocksDB value format
+short_double: Value is not in the RocksDB value format
+string_overrun: Value is not in the RocksDB value format
+huge_count: Value is not in the RocksDB value format
+bad_map_key: Value is not in the RocksDB value format
+array(2) {
+  ["plain"]=>
+  bool(false)
+  ["null"]=>
+  NULL
+}